@@ -6,6 +6,20 @@ struct AppWindow
 {
     wil::unique_hwnd m_window;
 
+    // Created on the first paint and recreated only when the DPI changes.
+    struct PaintResources
+    {
+        explicit PaintResources(const win32app::dpi_context& dpi) :
+            font(L"Segoe UI", dpi.scale(12.0f), Gdiplus::FontStyleRegular), // 24 pt
+            brush(Gdiplus::Color(255, 0, 100, 255))
+        {
+        }
+
+        Gdiplus::Font font;
+        Gdiplus::SolidBrush brush;
+    };
+    win32app::dpi_resources<PaintResources> m_paint;
+
     void Show(int nCmdShow)
     {
         Gdiplus::GdiplusStartupInput gdiplusStartupInput;
@@ -13,10 +27,9 @@ struct AppWindow
         Gdiplus::GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
 
         win32app::create_top_level_window(*this, L"Win32AppWindow");
-        const auto dpi = GetDpiForWindow(m_window.get());
-        const int dx = (600 * dpi) / 96;
-        const int dy = (800 * dpi) / 96;
-        SetWindowPos(m_window.get(), nullptr, 0, 0, dx, dy, SWP_NOACTIVATE | SWP_NOMOVE | SWP_NOZORDER);
+        m_paint.set_dpi(GetDpiForWindow(m_window.get()));
+        const auto& dpi = m_paint.context();
+        SetWindowPos(m_window.get(), nullptr, 0, 0, dpi.scale(600), dpi.scale(800), SWP_NOACTIVATE | SWP_NOMOVE | SWP_NOZORDER);
         win32app::enter_simple_message_loop(*this, nCmdShow);
     }
 
@@ -26,23 +39,24 @@ struct AppWindow
         return 0;
     }
 
+    LRESULT DpiChanged(UINT dpi, const RECT& suggested)
+    {
+        m_paint.set_dpi(dpi);
+        SetWindowPos(m_window.get(), nullptr, suggested.left, suggested.top, suggested.right - suggested.left,
+            suggested.bottom - suggested.top, SWP_NOACTIVATE | SWP_NOZORDER);
+        InvalidateRect(m_window.get(), nullptr, TRUE);
+        return 0;
+    }
+
     LRESULT Paint(HDC hdc, const PAINTSTRUCT& ps)
     {
         Gdiplus::Graphics graphics(hdc);
+        const auto& resources = m_paint.get();
 
-        const auto dpi = GetDpiForWindow(m_window.get());
-
-        const auto emSize = static_cast<float>((12.0 * dpi) / 96); // 24 pt
-        Gdiplus::Font font(L"Segoe UI", emSize, Gdiplus::FontStyleRegular);
-
-        Gdiplus::SolidBrush brush(Gdiplus::Color(255, 0, 100, 255));
-
-        const float drawOffset = 100; // view pixels
-        const float dpiScaledX = (drawOffset * dpi) / 96;
-        const float dpiScaledY = (drawOffset * dpi) / 96;
+        const float drawOffset = m_paint.context().scale(100.0f); // 100 view pixels
 
         const wchar_t message[]{L"Hello from GDIPlus!"};
-        graphics.DrawString(message, static_cast<int>(wcslen(message)), &font, {dpiScaledX, dpiScaledY}, &brush);
+        graphics.DrawString(message, static_cast<int>(wcslen(message)), &resources.font, {drawOffset, drawOffset}, &resources.brush);
         return 0;
     }
 };
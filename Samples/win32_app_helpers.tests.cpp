@@ -8,6 +8,7 @@
 // to develop WM_SIZE.
 
 #include <win32app/XamlHostWindow.h>
+#include <win32app/constraint_layout.h>
 
 namespace win32app::details
 {
@@ -67,6 +68,11 @@ void TestOneMessage()
             static_assert(msg<WM_DEVICECHANGE, Window>::is_valid);
             return 0;
         }
+        LRESULT DpiChanged(unsigned int dpi, const RECT& suggested)
+        {
+            static_assert(msg<WM_DPICHANGED, Window>::is_valid);
+            return 0;
+        }
     };
 
     static_assert(msg<value, Window>::is_valid, "'value' is not supported, update code above to add it.");
@@ -93,9 +99,100 @@ inline void TestUsage()
     TestOneMessage<WM_PAINT>();
     TestOneMessage<WM_COMMAND>();
     TestOneMessage<WM_DEVICECHANGE>();
+    TestOneMessage<WM_DPICHANGED>();
 }
 } // namespace win32app::details
 
+// Messages beyond the built in ones are registered with a message_traits specialization and listed by the window class.
+template <>
+struct win32app::message_traits<WM_TIMER>
+{
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.Timer(UINT_PTR{}); };
+
+    template <typename T>
+    static LRESULT dispatch(T& window, WPARAM wparam, LPARAM)
+    {
+        return window.Timer(static_cast<UINT_PTR>(wparam));
+    }
+};
+
+namespace win32app::details
+{
+struct TimerWindow
+{
+    wil::unique_hwnd m_window;
+    using messages = message_list<WM_TIMER>;
+
+    LRESULT Timer(UINT_PTR)
+    {
+        return 0;
+    }
+};
+
+struct CatchAllWindow
+{
+    wil::unique_hwnd m_window;
+
+    LRESULT HandleMessage(UINT32 message, WPARAM wparam, LPARAM lparam)
+    {
+        return DefWindowProcW(m_window.get(), message, wparam, lparam);
+    }
+};
+
+static_assert(msg<WM_TIMER, TimerWindow>::is_valid);
+static_assert(!msg<WM_SIZE, TimerWindow>::is_valid);
+static_assert(handles_message<CatchAllWindow, c_anyMessage>);
+static_assert(!handles_message<TimerWindow, c_anyMessage>);
+
+inline void TestDispatchCompiles(TimerWindow& timerWindow, CatchAllWindow& catchAllWindow)
+{
+    HandleMessage(&timerWindow, WM_TIMER, 1, 0);
+    HandleMessage(&catchAllWindow, WM_SIZE, 0, 0);
+}
+} // namespace win32app::details
+
+// The constraint layout solver is constexpr, these are evaluated by the compiler.
+namespace win32app::layout_tests
+{
+constexpr auto MakeTwoColumnTable()
+{
+    constraint_table<2> table{stack_constraints<2>(stack_orientation::horizontal)};
+    const std::array<layout_rect, 2> rects{{{10, 10, 95, 90}, {105, 10, 190, 90}}};
+    table.record(rects, {0, 0, 200, 100});
+    return table;
+}
+
+constexpr auto c_twoColumns = MakeTwoColumnTable();
+static_assert(c_twoColumns.compute({0, 0, 400, 100})[0] == layout_rect{10, 10, 195, 90});
+static_assert(c_twoColumns.compute({0, 0, 400, 100})[1] == layout_rect{205, 10, 390, 90});
+static_assert(c_twoColumns.compute({0, 0, 400, 200}, 192)[1] == layout_rect{210, 20, 380, 180}); // offsets scale with the DPI
+
+constexpr auto MakeClampedTable()
+{
+    constraint_table<1> table{{from_anchor(anchor_right | anchor_bottom).with_min_size(50, 0)}};
+    const std::array<layout_rect, 1> rects{{{80, 80, 90, 90}}};
+    table.record(rects, {0, 0, 100, 100});
+    return table;
+}
+
+// anchored to the right, the minimum width grows the control to the left
+static_assert(MakeClampedTable().compute({0, 0, 200, 150})[0] == layout_rect{140, 130, 190, 140});
+
+static_assert(from_anchor(anchor_left | anchor_right).right == layout_constraint::c_far);
+static_assert(grid_constraints<2, 3>()[5].left == 666);
+static_assert(grid_constraints<2, 3>()[5].bottom == layout_constraint::c_far);
+
+// anchors and constraints agree
+static_assert(anchor_rect(anchor_right | anchor_bottom, anchor_offsets(anchor_right | anchor_bottom, {10, 10, 30, 20}, {0, 0, 100, 100}), {0, 0, 200, 150}) ==
+              layout_rect{110, 60, 130, 70});
+
+// DPI scaling rounds like MulDiv
+static_assert(scale_for_dpi(600, 144) == 900);
+static_assert(scale_for_dpi(-3, 144) == -5);
+static_assert(dpi_context{192}.unscale(201) == 101);
+} // namespace win32app::layout_tests
+
 struct SimplestAppWindow
 {
     wil::unique_hwnd m_window;
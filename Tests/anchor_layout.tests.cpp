@@ -0,0 +1,47 @@
+#include "test_harness.h"
+
+#include <win32app/anchor_layout.h>
+
+using win32app::layout_rect;
+
+namespace
+{
+constexpr layout_rect c_client{0, 0, 400, 300};
+constexpr layout_rect c_wider{0, 0, 500, 350};
+} // namespace
+
+TEST_CASE(anchor_rect_follows_the_anchored_edges)
+{
+    constexpr layout_rect control{10, 20, 110, 44};
+    const uint8_t stretch = win32app::anchor_left | win32app::anchor_right | win32app::anchor_top | win32app::anchor_bottom;
+    CHECK((win32app::anchor_rect(stretch, win32app::anchor_offsets(stretch, control, c_client), c_wider) == layout_rect{10, 20, 210, 94}));
+
+    const uint8_t corner = win32app::anchor_right | win32app::anchor_bottom;
+    CHECK((win32app::anchor_rect(corner, win32app::anchor_offsets(corner, control, c_client), c_wider) == layout_rect{110, 70, 210, 94}));
+
+    CHECK((win32app::anchor_rect(win32app::anchor_none, win32app::anchor_offsets(win32app::anchor_none, control, c_client), c_wider) == control));
+}
+
+// The RECT array form of OnSize only replaces the edges that follow the far edge, a control the app moved keeps its position otherwise.
+TEST_CASE(anchor_far_edges_keeps_the_current_position)
+{
+    constexpr layout_rect recorded{10, 20, 110, 44};
+    constexpr layout_rect moved{30, 40, 130, 64};
+
+    const uint8_t stretch = win32app::anchor_left | win32app::anchor_right | win32app::anchor_top | win32app::anchor_bottom;
+    CHECK((win32app::anchor_far_edges(stretch, win32app::anchor_offsets(stretch, recorded, c_client), c_wider, moved) == layout_rect{30, 40, 210, 94}));
+
+    const uint8_t corner = win32app::anchor_right | win32app::anchor_bottom;
+    CHECK((win32app::anchor_far_edges(corner, win32app::anchor_offsets(corner, recorded, c_client), c_wider, moved) == layout_rect{110, 70, 210, 94}));
+
+    const uint8_t topLeft = win32app::anchor_left | win32app::anchor_top;
+    CHECK((win32app::anchor_far_edges(topLeft, win32app::anchor_offsets(topLeft, recorded, c_client), c_wider, moved) == moved));
+
+    // Not moved by the app, the same as anchor_rect.
+    for (uint8_t edges = 0; edges < 16; edges++)
+    {
+        const auto offsets = win32app::anchor_offsets(edges, recorded, c_client);
+        CHECK(win32app::anchor_far_edges(edges, offsets, c_client, recorded) == recorded);
+        CHECK(win32app::anchor_far_edges(edges, offsets, c_wider, win32app::anchor_rect(edges, offsets, c_client)) == win32app::anchor_rect(edges, offsets, c_wider));
+    }
+}
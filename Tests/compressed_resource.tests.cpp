@@ -0,0 +1,132 @@
+#include "test_harness.h"
+
+#include <win32app/compressed_resource.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::vector<std::string> make_inputs()
+{
+    std::mt19937 rng(29);
+    std::vector<std::string> inputs{"", "a", "abcd", "abcdabcdabcdabcd", std::string(100000, 'x')};
+
+    std::string markup;
+    while (markup.size() < 300000) // offsets up to the 64K window, long literal and match lengths
+    {
+        markup += "<TextBlock x:Name=\"Item" + std::to_string(rng() % 1000) + "\" Text=\"";
+        markup.append(rng() % 300, static_cast<char>('a' + rng() % 26));
+        markup += "\"/>\n";
+    }
+    inputs.push_back(markup);
+
+    std::string random(70000, '\0');
+    for (auto& ch : random)
+    {
+        ch = static_cast<char>(rng());
+    }
+    inputs.push_back(random);
+    return inputs;
+}
+
+bool decompresses_to(std::string_view block, size_t size)
+{
+    std::vector<unsigned char> output(size);
+    return win32app::lz4_decompress_block(block, output.data(), output.size());
+}
+} // namespace
+
+TEST_CASE(compressed_resource_round_trips)
+{
+    for (const auto& input : make_inputs())
+    {
+        const auto resource = win32app::make_compressed_resource(input);
+        const auto header = win32app::parse_compressed_resource_header(resource);
+        CHECK(header.has_value());
+        CHECK(header->decompressed_size == input.size());
+        const auto content = win32app::decompress_resource(*header);
+        CHECK(content.has_value() && (*content == input));
+    }
+}
+
+TEST_CASE(compressed_resource_uses_lz4_only_when_smaller)
+{
+    CHECK(win32app::parse_compressed_resource_header(win32app::make_compressed_resource(std::string(1000, 'x')))->codec ==
+          win32app::compression_codec::lz4_block);
+    CHECK(win32app::parse_compressed_resource_header(win32app::make_compressed_resource("abc"))->codec == win32app::compression_codec::stored);
+}
+
+TEST_CASE(compressed_resource_rejects_bad_headers)
+{
+    const auto resource = win32app::make_compressed_resource(std::string(1000, 'x'));
+    CHECK(!win32app::parse_compressed_resource_header(std::string_view(resource).substr(0, 11)));
+    CHECK(!win32app::parse_compressed_resource_header("W32Y" + resource.substr(4)));
+    CHECK(!win32app::parse_compressed_resource_header("<Grid/>"));
+
+    auto header = *win32app::parse_compressed_resource_header(resource);
+    header.codec = win32app::compression_codec::zstd;
+    CHECK(!win32app::decompress_resource(header));
+    header.codec = static_cast<win32app::compression_codec>(7);
+    CHECK(!win32app::decompress_resource(header));
+
+    auto stored = *win32app::parse_compressed_resource_header(win32app::make_compressed_resource("abc"));
+    stored.decompressed_size = 4;
+    CHECK(!win32app::decompress_resource(stored));
+}
+
+TEST_CASE(lz4_rejects_truncated_blocks)
+{
+    for (const auto& input : make_inputs())
+    {
+        const auto block = win32app::lz4_compress_block(input);
+        CHECK(decompresses_to(block, input.size()));
+        const size_t step = std::max<size_t>(1, block.size() / 2000);
+        for (size_t length = 0; length < block.size(); length += step)
+        {
+            if (!input.empty())
+            {
+                CHECK(!decompresses_to(std::string_view(block).substr(0, length), input.size()));
+            }
+        }
+        if (!input.empty())
+        {
+            CHECK(!decompresses_to(block, input.size() - 1)); // the destination is too small
+        }
+        CHECK(!decompresses_to(block, input.size() + 1)); // the block ends early
+    }
+}
+
+TEST_CASE(lz4_rejects_malformed_sequences)
+{
+    // token: 1 literal and a match of 4, then the offset
+    CHECK(decompresses_to(std::string_view("\x10" "a" "\x01\x00", 4), 5));
+    CHECK(!decompresses_to(std::string_view("\x10" "a" "\x00\x00", 4), 5)); // offset 0
+    CHECK(!decompresses_to(std::string_view("\x10" "a" "\x02\x00", 4), 5)); // offset before the start of the output
+    CHECK(!decompresses_to(std::string_view("\x10" "a" "\x01", 3), 5));     // offset cut short
+    CHECK(!decompresses_to(std::string_view("\xF0", 1), 15));               // literal length bytes missing
+    CHECK(!decompresses_to(std::string_view("\xF0\xFF\xFF", 3), 600));      // literal length bytes cut short
+    CHECK(!decompresses_to(std::string_view("\x50" "abc", 4), 5));          // literals past the end of the input
+    CHECK(!decompresses_to(std::string_view("\x1F" "a" "\x01\x00", 4), 100)); // match length bytes missing
+}
+
+TEST_CASE(lz4_survives_corrupt_blocks)
+{
+    std::mt19937 rng(30);
+    const auto inputs = make_inputs();
+    for (int i = 0; i < 20000; i++)
+    {
+        const auto& input = inputs[rng() % inputs.size()];
+        auto block = win32app::lz4_compress_block(input.substr(0, 4096));
+        if (block.empty())
+        {
+            continue;
+        }
+        for (auto changes = 1 + rng() % 4; changes > 0; changes--)
+        {
+            block[rng() % block.size()] = static_cast<char>(rng());
+        }
+        decompresses_to(block, std::min<size_t>(input.size(), 4096)); // may fail, must stay in bounds
+    }
+}
@@ -0,0 +1,85 @@
+#include "test_harness.h"
+
+#include <win32app/dpi_context.h>
+
+#include <vector>
+
+namespace
+{
+// Stands in for fonts and brushes, records the DPI each instance was created for and how many are alive.
+// Not copyable or movable, like a Gdiplus::Font.
+struct fake_resources
+{
+    explicit fake_resources(const win32app::dpi_context& context) : dpi(context.dpi), fontHeight(context.scale(12))
+    {
+        s_created.push_back(context.dpi);
+        s_alive++;
+    }
+
+    ~fake_resources()
+    {
+        s_alive--;
+    }
+
+    fake_resources(const fake_resources&) = delete;
+    fake_resources& operator=(const fake_resources&) = delete;
+
+    uint32_t dpi;
+    int32_t fontHeight;
+
+    inline static std::vector<uint32_t> s_created;
+    inline static int s_alive{};
+};
+} // namespace
+
+TEST_CASE(dpi_context_scales_like_muldiv)
+{
+    static_assert(win32app::scale_for_dpi(10, 144) == 15);
+    static_assert(win32app::scale_for_dpi(-10, 144) == -15);
+    static_assert(win32app::scale_for_dpi(1, 120) == 1); // 1.25 rounds down
+    static_assert(win32app::scale_for_dpi(3, 120) == 4); // 3.75 rounds up
+
+    constexpr win32app::dpi_context dpi{192};
+    static_assert(dpi.scale(7) == 14);
+    static_assert(dpi.unscale(dpi.scale(7)) == 7);
+    CHECK(dpi.scale(1.5f) == 3.0f);
+    CHECK((win32app::dpi_context{}.scale(33) == 33));
+}
+
+TEST_CASE(dpi_resources_are_created_once_per_dpi)
+{
+    fake_resources::s_created.clear();
+    {
+        win32app::dpi_resources<fake_resources> resources;
+        CHECK(resources.dpi() == win32app::c_defaultDpi);
+        CHECK(resources.creations() == 0); // nothing until first use
+        CHECK(fake_resources::s_alive == 0);
+
+        CHECK(!resources.set_dpi(96));
+        CHECK(resources.set_dpi(144));
+        CHECK(resources.get().dpi == 144);
+        CHECK(resources.get().fontHeight == 18);
+        CHECK(&resources.get() == &resources.get());
+        CHECK(resources.creations() == 1);
+
+        // Setting the same DPI again, as a WM_DPICHANGED for a move between monitors of the same DPI does, keeps them.
+        CHECK(!resources.set_dpi(144));
+        resources.get();
+        CHECK(resources.creations() == 1);
+
+        // A new DPI drops them at once and creates them again on next use only.
+        CHECK(resources.set_dpi(192));
+        CHECK(fake_resources::s_alive == 0);
+        CHECK(resources.context().scale(12) == 24);
+        CHECK(resources.get().fontHeight == 24);
+        CHECK(resources.creations() == 2);
+
+        resources.reset();
+        CHECK(fake_resources::s_alive == 0);
+        CHECK(resources.get().dpi == 192);
+        CHECK(resources.creations() == 3);
+        CHECK(fake_resources::s_alive == 1);
+    }
+    CHECK(fake_resources::s_alive == 0);
+    CHECK((fake_resources::s_created == std::vector<uint32_t>{144, 192, 192}));
+}
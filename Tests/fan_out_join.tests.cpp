@@ -0,0 +1,147 @@
+#include "test_harness.h"
+
+#include <win32app/fan_out_join.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+// Stands in for a window's DispatcherQueue, runs posted work in order on its own thread.
+struct fake_dispatcher
+{
+    fake_dispatcher() : m_thread([this] { run(); })
+    {
+    }
+
+    ~fake_dispatcher()
+    {
+        post(nullptr);
+        m_thread.join();
+    }
+
+    void post(std::function<void()> work)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_work.push_back(std::move(work));
+        m_cv.notify_one();
+    }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            std::function<void()> work;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_cv.wait(lock, [&] { return !m_work.empty(); });
+                work = std::move(m_work.front());
+                m_work.pop_front();
+            }
+            if (!work)
+            {
+                return;
+            }
+            work();
+        }
+    }
+
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_work;
+    std::thread m_thread;
+};
+
+// What BroadcastAsync does, post fn to every dispatcher and join the completions.
+std::shared_ptr<win32app::fan_out_join> broadcast(std::vector<std::unique_ptr<fake_dispatcher>>& dispatchers, std::function<void(size_t)> fn,
+    std::function<void()> onAllComplete = {})
+{
+    auto join = std::make_shared<win32app::fan_out_join>(dispatchers.size(), std::move(onAllComplete));
+    for (size_t i = 0; i < dispatchers.size(); i++)
+    {
+        dispatchers[i]->post([join, i, fn] {
+            fn(i);
+            join->complete(i);
+        });
+    }
+    return join;
+}
+
+std::vector<std::unique_ptr<fake_dispatcher>> make_dispatchers(size_t count)
+{
+    std::vector<std::unique_ptr<fake_dispatcher>> result;
+    for (size_t i = 0; i < count; i++)
+    {
+        result.push_back(std::make_unique<fake_dispatcher>());
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE(fan_out_join_waits_for_all)
+{
+    auto dispatchers = make_dispatchers(8);
+    std::atomic<int> ran{};
+    std::atomic<int> callbacks{};
+    auto join = broadcast(dispatchers, [&](size_t) { ran++; }, [&] { callbacks++; });
+    CHECK(join->wait_for(10s));
+    CHECK(ran == 8);
+    CHECK(callbacks == 1);
+    CHECK(join->pending().empty());
+    for (size_t i = 0; i < dispatchers.size(); i++)
+    {
+        CHECK(join->elapsed(i).has_value());
+    }
+}
+
+TEST_CASE(fan_out_join_reports_slow_operations)
+{
+    auto dispatchers = make_dispatchers(4);
+    std::mutex blockLock;
+    std::unique_lock<std::mutex> blocked(blockLock);
+    auto join = broadcast(dispatchers, [&](size_t i) {
+        if (i == 2)
+        {
+            std::lock_guard<std::mutex> wait(blockLock); // a window thread that is busy
+        }
+    });
+
+    CHECK(!join->wait_for(50ms));
+    CHECK((join->pending() == std::vector<size_t>{2}));
+    CHECK(!join->elapsed(2));
+    CHECK(join->elapsed(0).has_value());
+
+    blocked.unlock();
+    CHECK(join->wait_for(10s));
+    CHECK(join->pending().empty());
+    CHECK(join->elapsed(2) && (*join->elapsed(2) >= 50ms)); // completed late, with its time
+}
+
+TEST_CASE(fan_out_join_completes_after_the_owner_stops_waiting)
+{
+    std::atomic<bool> allComplete{};
+    {
+        auto dispatchers = make_dispatchers(2);
+        auto join = broadcast(dispatchers, [](size_t i) { std::this_thread::sleep_for(i * 20ms); }, [&] { allComplete = true; });
+        // the owner drops its reference, the dispatchers still hold the join
+    }
+    CHECK(allComplete);
+}
+
+TEST_CASE(fan_out_join_with_no_operations)
+{
+    bool called = false;
+    win32app::fan_out_join join(0, [&] { called = true; });
+    CHECK(called);
+    CHECK(join.is_complete());
+    CHECK(join.wait_for(0ms));
+}
@@ -0,0 +1,83 @@
+#include "test_harness.h"
+
+#include "../Tools/win32_shim.h"
+#include <win32app/message_dispatch.h>
+
+#include <vector>
+
+namespace
+{
+constexpr unsigned int c_timerMessage = 0x0113; // WM_TIMER
+constexpr unsigned int c_appMessage = 0x8000;   // WM_APP
+
+struct size_window
+{
+    win32_shim::unique_hwnd m_window;
+    std::vector<UINT32> m_caught;
+
+    LRESULT Size(unsigned short dx, unsigned short dy)
+    {
+        return dx * 1000 + dy;
+    }
+
+    LRESULT HandleMessage(UINT32 message, WPARAM, LPARAM)
+    {
+        m_caught.push_back(message);
+        return 42;
+    }
+};
+
+struct timer_window
+{
+    win32_shim::unique_hwnd m_window;
+    using messages = win32app::message_list<c_timerMessage, WM_SIZE>;
+
+    LRESULT Timer(uintptr_t id)
+    {
+        return static_cast<LRESULT>(id) + 1;
+    }
+};
+} // namespace
+
+template <>
+struct win32app::message_traits<c_timerMessage>
+{
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.Timer(uintptr_t{}); };
+
+    template <typename T>
+    static LRESULT dispatch(T& window, WPARAM wparam, LPARAM)
+    {
+        return window.Timer(static_cast<uintptr_t>(wparam));
+    }
+};
+
+static_assert(std::is_same_v<decltype(win32app::details::handled_messages<size_window>(win32app::message_list<WM_MOVE, WM_SIZE, WM_PAINT>{})),
+    win32app::message_list<WM_SIZE>>);
+static_assert(std::is_same_v<decltype(win32app::details::handled_messages<timer_window>(win32app::message_list<c_timerMessage, WM_SIZE>{})),
+    win32app::message_list<c_timerMessage>>);
+
+TEST_CASE(message_dispatch_calls_the_handler)
+{
+    size_window window;
+    CHECK(win32app::details::HandleMessage(&window, WM_SIZE, 0, MAKELPARAM(3, 4)) == 3004);
+    CHECK(window.m_caught.empty());
+
+    timer_window timer;
+    CHECK(win32app::details::HandleMessage(&timer, c_timerMessage, 7, 0) == 8);
+    CHECK(win32app::details::HandleMessage(&timer, WM_SIZE, 0, MAKELPARAM(3, 4)) == 0); // listed, not handled
+}
+
+TEST_CASE(message_dispatch_leaves_built_in_messages_to_the_default)
+{
+    size_window window;
+    for (const UINT32 message : {WM_PAINT, WM_MOVE, WM_CREATE, WM_DESTROY, WM_COMMAND, WM_DEVICECHANGE, WM_DPICHANGED})
+    {
+        CHECK(win32app::details::HandleMessage(&window, message, 0, 0) == 0);
+    }
+    CHECK(window.m_caught.empty());
+
+    CHECK(win32app::details::HandleMessage(&window, c_appMessage, 0, 0) == 42);
+    CHECK(win32app::details::HandleMessage(&window, c_timerMessage, 0, 0) == 42);
+    CHECK((window.m_caught == std::vector<UINT32>{c_appMessage, c_timerMessage}));
+}
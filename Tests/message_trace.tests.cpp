@@ -0,0 +1,150 @@
+#include "test_harness.h"
+
+#include <win32app/message_trace.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::vector<win32app::message_record> sample_records()
+{
+    return {
+        {0, 0x1000, 0, 0x00C80190, 0x0005}, // WM_SIZE 400x200
+        {1500000, 0x1000, 1, 0x00100020, 0x0200}, // WM_MOUSEMOVE
+        {2500000, 0x2000, 0xFFFFFFFFFFFFFFFF, -1, 0x0111}, // WM_COMMAND, all bits of the parameters
+        {4000000, 0x1000, 0x41, 0x001E0001, 0x0100}, // WM_KEYDOWN 'A'
+        {4000001, 0xFFFFFFFFFFFFFFFF, 0, INT64_MIN, 0xFFFFFFFF}, // extremes survive
+    };
+}
+} // namespace
+
+TEST_CASE(message_trace_round_trips)
+{
+    const auto records = sample_records();
+    const auto trace = win32app::make_message_trace(records);
+    CHECK(trace.size() == win32app::c_messageTraceHeaderSize + records.size() * win32app::c_messageRecordSize);
+    CHECK(trace.starts_with("W32M"));
+
+    const auto read = win32app::read_message_trace(trace);
+    CHECK(read.has_value());
+    CHECK(*read == records);
+
+    const auto empty = win32app::read_message_trace(win32app::make_message_trace({}));
+    CHECK(empty && empty->empty());
+}
+
+TEST_CASE(message_trace_rejects_other_content)
+{
+    const auto trace = win32app::make_message_trace(sample_records());
+    CHECK(!win32app::read_message_trace(""));
+    CHECK(!win32app::read_message_trace("W32"));
+    CHECK(!win32app::read_message_trace("X32M" + trace.substr(4)));
+    CHECK(!win32app::read_message_trace(std::string_view(trace).substr(0, trace.size() - 1))); // truncated record
+
+    auto shortRecords = trace;
+    shortRecords[6] = static_cast<char>(win32app::c_messageRecordSize - 1);
+    CHECK(!win32app::read_message_trace(shortRecords));
+}
+
+// A later version may add fields at the end of each record, the known fields are still read.
+TEST_CASE(message_trace_reads_longer_records)
+{
+    const auto records = sample_records();
+    const auto trace = win32app::make_message_trace(records);
+    constexpr size_t extra = 4;
+    std::string newer = trace.substr(0, win32app::c_messageTraceHeaderSize);
+    newer[4] = 2; // version
+    newer[6] = static_cast<char>(win32app::c_messageRecordSize + extra);
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        newer += trace.substr(win32app::c_messageTraceHeaderSize + i * win32app::c_messageRecordSize, win32app::c_messageRecordSize);
+        newer.append(extra, '\x7F');
+    }
+    const auto read = win32app::read_message_trace(newer);
+    CHECK(read && (*read == records));
+}
+
+TEST_CASE(message_recorder_drops_past_capacity)
+{
+    win32app::message_recorder recorder(3);
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        recorder.record(0x1000, 0x0200, i, -static_cast<int64_t>(i));
+    }
+    CHECK(recorder.dropped() == 2);
+    auto records = recorder.take();
+    CHECK(records.size() == 3);
+    CHECK((records[2].wparam == 2) && (records[2].lparam == -2) && (records[2].message == 0x0200));
+    CHECK((records[0].time_ns <= records[1].time_ns) && (records[1].time_ns <= records[2].time_ns));
+    CHECK(recorder.take().empty());
+
+    recorder.restart();
+    CHECK(recorder.dropped() == 0);
+    recorder.record(0x1000, 0x0005, 0, 0);
+    CHECK(recorder.take().size() == 1);
+}
+
+// Replays through a stub dispatch, the handlers of a window are not needed to check the order and the report.
+TEST_CASE(message_trace_replays_through_a_stub)
+{
+    const auto records = sample_records();
+    std::vector<uint32_t> dispatched;
+    const auto report = win32app::replay_messages(records, [&](const win32app::message_record& record) {
+        dispatched.push_back(record.message);
+        if (record.message == 0x0200)
+        {
+            const auto spinUntil = std::chrono::steady_clock::now() + std::chrono::milliseconds(2); // the expensive handler
+            while (std::chrono::steady_clock::now() < spinUntil)
+            {
+            }
+        }
+    });
+
+    CHECK((dispatched == std::vector<uint32_t>{0x0005, 0x0200, 0x0111, 0x0100, 0xFFFFFFFF}));
+    CHECK(report.replayed == records.size());
+    CHECK(report.messages.size() == records.size());
+    CHECK(report.messages.front().message == 0x0200); // most expensive first
+    CHECK(report.messages.front().count == 1);
+    CHECK(report.messages.front().max >= std::chrono::milliseconds(2));
+    CHECK(report.handler_time >= report.messages.front().total);
+    CHECK(report.elapsed >= report.handler_time);
+
+    // In real time the replay keeps the recorded spacing, 4ms from the first to the last record.
+    const auto realTime = win32app::replay_messages(records, [](const win32app::message_record&) {}, win32app::replay_speed::real_time);
+    CHECK(realTime.elapsed >= std::chrono::milliseconds(4));
+
+    CHECK(win32app::replay_messages({}, [](const win32app::message_record&) {}).replayed == 0);
+}
+
+TEST_CASE(message_trace_replays_only_value_messages)
+{
+    // Input, WM_SIZE, WM_MOVE and WM_COMMAND.
+    for (const uint32_t message : {0x0003u, 0x0005u, 0x0100u, 0x0101u, 0x0102u, 0x0111u, 0x0200u, 0x0201u, 0x020Au, 0x020Eu, 0x02A3u})
+    {
+        CHECK(win32app::is_replayable_message(message));
+    }
+
+    // Pointers, callbacks and messages whose default handling acts on the window.
+    for (const uint32_t message : {
+             0x0001u, // WM_CREATE
+             0x0002u, // WM_DESTROY
+             0x0010u, // WM_CLOSE
+             0x001Au, // WM_SETTINGCHANGE
+             0x002Bu, // WM_DRAWITEM
+             0x002Cu, // WM_MEASUREITEM
+             0x004Eu, // WM_NOTIFY
+             0x0104u, // WM_SYSKEYDOWN, Alt+F4
+             0x0112u, // WM_SYSCOMMAND, SC_CLOSE
+             0x0113u, // WM_TIMER, may carry a TIMERPROC
+             0x00A1u, // WM_NCLBUTTONDOWN
+             0x0214u, // WM_SIZING
+             0x0216u, // WM_MOVING
+             0x02E0u, // WM_DPICHANGED
+             0x8000u, // WM_APP
+         })
+    {
+        CHECK(!win32app::is_replayable_message(message));
+    }
+}
@@ -0,0 +1,36 @@
+// portable_tests
+//
+// Runs the tests of the portable headers, see test_harness.h. Returns non zero if a check failed.
+//
+//    portable_tests                      all tests
+//    portable_tests resource_cache       the tests whose name contains "resource_cache"
+//
+// Build all the *.cpp files of this directory, for example
+//    cl /std:c++20 /EHsc /I..\inc *.cpp /Fe:portable_tests.exe
+//    g++ -std=c++20 -pthread -I../inc *.cpp -o portable_tests
+
+#include "test_harness.h"
+
+#include <cstdio>
+#include <string_view>
+
+int main(int argc, char** argv)
+{
+    const std::string_view filter = (argc > 1) ? argv[1] : "";
+    int ran{};
+    for (const auto& test : win32app::tests::registered_tests())
+    {
+        if (!filter.empty() && (test.name.find(filter) == std::string_view::npos))
+        {
+            continue;
+        }
+
+        const auto failedBefore = win32app::tests::failed_checks();
+        test.run();
+        std::fprintf(stderr, "%s %.*s\n", (win32app::tests::failed_checks() == failedBefore) ? "passed" : "FAILED",
+            static_cast<int>(test.name.size()), test.name.data());
+        ran++;
+    }
+    std::fprintf(stderr, "%d tests, %d failed checks\n", ran, win32app::tests::failed_checks());
+    return (win32app::tests::failed_checks() == 0) ? 0 : 1;
+}
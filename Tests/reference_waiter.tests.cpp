@@ -0,0 +1,189 @@
+#include "test_harness.h"
+
+#include <win32app/reference_waiter.h>
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+// A coroutine that starts immediately and is not awaited.
+struct fire_and_forget
+{
+    struct promise_type
+    {
+        fire_and_forget get_return_object() noexcept
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() noexcept
+        {
+        }
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+template <typename TWaiter>
+fire_and_forget resume_when_zero(TWaiter& waiter, std::atomic<std::thread::id>& resumedOn)
+{
+    co_await waiter.when_zero();
+    resumedOn = std::this_thread::get_id();
+}
+
+template <typename TWaiter>
+void check_waits_for_holders_on_other_threads()
+{
+    TWaiter waiter;
+    std::atomic<int> released{};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++)
+    {
+        // The reference is released when the thread destroys the lambda.
+        threads.emplace_back([&, reference = waiter.take_reference()] {
+            std::this_thread::sleep_for(10ms);
+            released++;
+        });
+    }
+    waiter.wait_until_zero();
+    CHECK(released == 8);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+template <typename TWaiter>
+void check_timed_wait()
+{
+    TWaiter waiter;
+    CHECK(waiter.wait_until_zero_for(0ms));
+
+    std::optional<decltype(waiter.take_reference())> reference;
+    reference.emplace(waiter.take_reference());
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(!waiter.wait_until_zero_for(20ms));
+    CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(10ms);
+        reference.reset();
+    });
+    CHECK(waiter.wait_until_zero_for(10s));
+    releaser.join();
+}
+
+template <typename TWaiter>
+void check_when_zero()
+{
+    TWaiter waiter;
+    std::atomic<std::thread::id> resumedOn{};
+    resume_when_zero(waiter, resumedOn); // zero, does not suspend
+    CHECK(resumedOn.load() == std::this_thread::get_id());
+
+    resumedOn = std::thread::id{};
+    auto first = std::make_optional(waiter.take_reference());
+    auto second = std::make_optional(waiter.take_reference());
+    resume_when_zero(waiter, resumedOn);
+    CHECK(resumedOn.load() == std::thread::id{});
+    first.reset();
+    CHECK(resumedOn.load() == std::thread::id{});
+
+    std::thread releaser([&] { second.reset(); });
+    const auto releaserId = releaser.get_id();
+    releaser.join();
+    CHECK(resumedOn.load() == releaserId); // inline, on the thread that released the last reference
+    CHECK(waiter.wait_until_zero_for(0ms));
+}
+
+template <typename TWaiter>
+void check_moves_transfer_the_reference()
+{
+    TWaiter waiter;
+    auto reference = waiter.take_reference();
+    auto moved = std::move(reference);
+    CHECK(!waiter.wait_until_zero_for(0ms));
+    {
+        auto last = std::move(moved);
+    }
+    CHECK(waiter.wait_until_zero_for(0ms));
+}
+
+template <typename TWaiter>
+void check_concurrent_take_release()
+{
+    TWaiter waiter;
+    std::atomic<bool> done{};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++)
+    {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 20000; j++)
+            {
+                auto reference = waiter.take_reference();
+            }
+        });
+    }
+    std::thread waiting([&] { // timed waits racing with the releases
+        while (!done)
+        {
+            waiter.wait_until_zero_for(1ms);
+        }
+    });
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    waiter.wait_until_zero();
+    done = true;
+    waiting.join();
+    CHECK(waiter.wait_until_zero_for(0ms));
+}
+} // namespace
+
+TEST_CASE(reference_waiter_waits_for_holders_on_other_threads)
+{
+    check_waits_for_holders_on_other_threads<reference_waiter>();
+    check_waits_for_holders_on_other_threads<sharded_reference_waiter<>>();
+}
+
+TEST_CASE(reference_waiter_timed_wait)
+{
+    check_timed_wait<reference_waiter>();
+    check_timed_wait<sharded_reference_waiter<>>();
+}
+
+TEST_CASE(reference_waiter_when_zero)
+{
+    check_when_zero<reference_waiter>();
+    check_when_zero<sharded_reference_waiter<>>();
+}
+
+TEST_CASE(reference_waiter_moves_transfer_the_reference)
+{
+    check_moves_transfer_the_reference<reference_waiter>();
+    check_moves_transfer_the_reference<sharded_reference_waiter<>>();
+}
+
+TEST_CASE(reference_waiter_concurrent_take_release)
+{
+    check_concurrent_take_release<reference_waiter>();
+    check_concurrent_take_release<sharded_reference_waiter<4>>();
+}
@@ -0,0 +1,148 @@
+#include "test_harness.h"
+
+#include <win32app/resize_throttle.h>
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+using clock_type = win32app::resize_throttle::clock;
+
+// Drives a resize_throttle the way OnResizeMessage does, with a one shot timer that fires at its deadline
+// before any later size change. Each size change is a new size, layouts records which size was laid out.
+struct simulated_drag
+{
+    win32app::resize_throttle throttle{16ms};
+    clock_type::time_point now = clock_type::time_point{} + 1s;
+    std::optional<clock_type::time_point> timer;
+    int size{};
+    int laidOut{};
+    std::vector<int> layouts;
+    size_t immediate{}; // size changes laid out when they arrived
+
+    void layout()
+    {
+        laidOut = size;
+        layouts.push_back(size);
+    }
+
+    void advance_to(clock_type::time_point time)
+    {
+        if (timer && (*timer <= time))
+        {
+            now = *timer;
+            timer.reset();
+            if (throttle.timer_elapsed(now))
+            {
+                layout();
+            }
+        }
+        now = time;
+    }
+
+    void size_changed(clock_type::duration after)
+    {
+        advance_to(now + after);
+        size++;
+        const auto decision = throttle.size_changed(now);
+        if (decision.layout)
+        {
+            immediate++;
+            layout();
+        }
+        if (decision.arm_timer)
+        {
+            CHECK(!timer);
+            CHECK(decision.timer_delay > 0ns);
+            CHECK(decision.timer_delay <= 16ms);
+            timer = now + decision.timer_delay;
+        }
+    }
+
+    void exit_size_move()
+    {
+        timer.reset();
+        throttle.exit_size_move();
+        layout();
+    }
+};
+} // namespace
+
+TEST_CASE(resize_throttle_lays_out_every_change_outside_a_drag)
+{
+    simulated_drag drag;
+    for (int i = 0; i < 10; i++)
+    {
+        drag.size_changed(1ms);
+    }
+    CHECK(drag.layouts.size() == 10);
+    CHECK(!drag.timer);
+    CHECK(drag.throttle.deferred() == 0);
+}
+
+TEST_CASE(resize_throttle_limits_a_drag_to_the_frame_rate)
+{
+    simulated_drag drag;
+    drag.throttle.enter_size_move();
+    for (int i = 0; i < 500; i++) // one second of a 500Hz mouse
+    {
+        drag.size_changed(2ms);
+    }
+    drag.advance_to(drag.now + 100ms);
+
+    // At most one layout per 16ms frame, and the last size is laid out by the timer.
+    CHECK(drag.layouts.size() >= 1000 / 16 - 2);
+    CHECK(drag.layouts.size() <= 1000 / 16 + 2);
+    CHECK(drag.laidOut == drag.size);
+    CHECK(drag.throttle.layouts() == drag.layouts.size());
+    CHECK(drag.throttle.deferred() + drag.immediate == 500);
+
+    drag.exit_size_move();
+    CHECK(!drag.throttle.is_live());
+    CHECK(drag.laidOut == drag.size);
+}
+
+TEST_CASE(resize_throttle_commits_the_last_size_when_the_drag_pauses)
+{
+    simulated_drag drag;
+    drag.throttle.enter_size_move();
+    drag.size_changed(1ms); // laid out, first in the drag
+    drag.size_changed(1ms); // deferred, arms the timer
+    drag.size_changed(1ms); // deferred, the timer is already armed
+    CHECK(drag.layouts.size() == 1);
+    CHECK(drag.timer.has_value());
+
+    drag.advance_to(drag.now + 50ms);
+    CHECK(!drag.timer);
+    CHECK(drag.layouts.size() == 2);
+    CHECK(drag.laidOut == 3);
+
+    // The timer fired with nothing pending after a layout, it does not lay out again.
+    drag.size_changed(1ms);
+    drag.size_changed(1ms);
+    drag.size_changed(20ms);
+    drag.advance_to(drag.now + 50ms);
+    CHECK(drag.laidOut == drag.size);
+    CHECK(drag.throttle.timer_elapsed(drag.now) == false);
+}
+
+TEST_CASE(resize_throttle_exit_lays_out_exactly_once)
+{
+    simulated_drag drag;
+    drag.throttle.enter_size_move();
+    drag.size_changed(1ms);
+    drag.size_changed(1ms);
+    const auto layoutsBefore = drag.layouts.size();
+    drag.exit_size_move();
+    CHECK(drag.layouts.size() == layoutsBefore + 1);
+    CHECK(drag.laidOut == drag.size);
+
+    // The cancelled timer has no effect after the drag.
+    CHECK(drag.throttle.timer_elapsed(drag.now + 1s) == false);
+    drag.size_changed(1ms);
+    CHECK(drag.layouts.size() == layoutsBefore + 2);
+}
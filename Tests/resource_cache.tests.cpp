@@ -0,0 +1,110 @@
+#include "test_harness.h"
+
+#include <win32app/resource_cache.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// MAKEINTRESOURCEW()
+const wchar_t* make_int_resource(uintptr_t id)
+{
+    return reinterpret_cast<const wchar_t*>(id);
+}
+
+const auto c_rtRcData = make_int_resource(10);
+const auto c_rtString = make_int_resource(6);
+} // namespace
+
+TEST_CASE(resource_cache_creates_once_per_key)
+{
+    win32app::resource_cache<std::wstring> cache;
+    int module{};
+    int created{};
+    auto factory = [&] {
+        created++;
+        return std::wstring(L"decoded");
+    };
+
+    const auto& first = cache.get_or_create(&module, L"AppWindow.xaml", c_rtRcData, factory);
+    const auto& second = cache.get_or_create(&module, L"AppWindow.xaml", c_rtRcData, factory);
+    CHECK(created == 1);
+    CHECK(&first == &second);
+    CHECK(first == L"decoded");
+    CHECK(cache.stats().hits == 1);
+    CHECK(cache.stats().misses == 1);
+}
+
+TEST_CASE(resource_cache_keys_on_module_name_and_type)
+{
+    win32app::resource_cache<int> cache;
+    int module{};
+    int otherModule{};
+    int next{};
+    auto factory = [&] { return ++next; };
+
+    CHECK(cache.get_or_create(&module, L"A", c_rtRcData, factory) == 1);
+    CHECK(cache.get_or_create(&otherModule, L"A", c_rtRcData, factory) == 2);
+    CHECK(cache.get_or_create(&module, L"B", c_rtRcData, factory) == 3);
+    CHECK(cache.get_or_create(&module, L"A", c_rtString, factory) == 4);
+    CHECK(cache.get_or_create(&module, make_int_resource(101), c_rtRcData, factory) == 5);
+    CHECK(cache.get_or_create(&module, make_int_resource(102), c_rtRcData, factory) == 6);
+    CHECK(cache.get_or_create(&module, make_int_resource(101), c_rtRcData, factory) == 5);
+    CHECK(cache.get_or_create(&module, L"A", c_rtRcData, factory) == 1);
+    CHECK(cache.stats().misses == 6);
+    CHECK(cache.stats().hits == 2);
+}
+
+TEST_CASE(resource_cache_copies_string_names)
+{
+    win32app::resource_cache<int> cache;
+    int module{};
+    std::wstring name(L"Settings.json");
+    cache.get_or_create(&module, name.c_str(), c_rtRcData, [] { return 1; });
+    name = L"Other.json"; // the callers buffer changes, the key does not
+
+    CHECK(cache.get_or_create(&module, L"Settings.json", c_rtRcData, [] { return 2; }) == 1);
+    CHECK(cache.get_or_create(&module, name.c_str(), c_rtRcData, [] { return 3; }) == 3);
+}
+
+TEST_CASE(resource_cache_concurrent_first_use_creates_once)
+{
+    win32app::resource_cache<std::wstring> cache;
+    int module{};
+    std::atomic<int> created{};
+    std::atomic<bool> go{};
+    std::vector<const std::wstring*> results(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        threads.emplace_back([&, i] {
+            while (!go.load())
+            {
+                std::this_thread::yield();
+            }
+            for (int round = 0; round < 1000; round++)
+            {
+                results[i] = &cache.get_or_create(&module, make_int_resource(1 + (round % 16)), c_rtRcData, [&] {
+                    created++;
+                    return std::wstring(L"value");
+                });
+            }
+        });
+    }
+    go = true;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(created == 16);
+    CHECK(cache.stats().misses == 16);
+    CHECK(cache.stats().hits + cache.stats().misses == 8 * 1000);
+    for (auto result : results)
+    {
+        CHECK(result == results.front()); // the same entry, the last round used the same key
+    }
+}
@@ -0,0 +1,117 @@
+#include "test_harness.h"
+
+#include <win32app/rundown_loop.h>
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+// Time only moves when the loop waits.
+struct fake_clock
+{
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<fake_clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now()
+    {
+        return s_now;
+    }
+
+    inline static time_point s_now{};
+};
+
+// A message queue on the fake clock, messages become available at their time and the quit message at quitTime.
+struct fake_queue
+{
+    std::vector<fake_clock::time_point> messages;
+    std::optional<fake_clock::time_point> quitTime;
+    size_t dispatched{};
+    std::vector<std::chrono::milliseconds> waits;
+
+    bool dispatch_pending()
+    {
+        while ((dispatched < messages.size()) && (messages[dispatched] <= fake_clock::now()))
+        {
+            dispatched++;
+        }
+        // WM_QUIT is retrieved only once the messages posted before it are dispatched.
+        return quitTime && (*quitTime <= fake_clock::now()) && (dispatched == messages.size());
+    }
+
+    // Returns at the next message or after remaining, like MsgWaitForMultipleObjectsEx.
+    void wait(std::chrono::milliseconds remaining)
+    {
+        waits.push_back(remaining);
+        auto until = fake_clock::now() + remaining;
+        if ((dispatched < messages.size()) && (messages[dispatched] < until))
+        {
+            until = messages[dispatched];
+        }
+        if (quitTime && (*quitTime > fake_clock::now()) && (*quitTime < until))
+        {
+            until = *quitTime;
+        }
+        fake_clock::s_now = until;
+    }
+
+    bool run(std::chrono::milliseconds timeout)
+    {
+        return win32app::run_until_quit<fake_clock>(
+            fake_clock::now() + timeout, [&] { return dispatch_pending(); }, [&](std::chrono::milliseconds remaining) { wait(remaining); });
+    }
+};
+} // namespace
+
+TEST_CASE(rundown_loop_returns_when_quit_is_retrieved)
+{
+    fake_clock::s_now = {};
+    fake_queue queue;
+    queue.messages = {fake_clock::time_point{5ms}, fake_clock::time_point{20ms}};
+    queue.quitTime = fake_clock::time_point{0ms}; // posted first, retrieved after the other messages
+    CHECK(queue.run(100ms));
+    CHECK(queue.dispatched == 2);
+    CHECK(fake_clock::now() == fake_clock::time_point{20ms});
+}
+
+TEST_CASE(rundown_loop_times_out_while_messages_keep_arriving)
+{
+    fake_clock::s_now = {};
+    fake_queue queue;
+    for (int i = 1; i <= 50; i++)
+    {
+        queue.messages.push_back(fake_clock::time_point{std::chrono::milliseconds(i * 3)});
+    }
+    queue.quitTime = fake_clock::time_point{0ms};
+    CHECK(!queue.run(100ms));
+    CHECK(fake_clock::now() == fake_clock::time_point{100ms});
+    CHECK(queue.dispatched == 33); // those up to the deadline
+    for (const auto remaining : queue.waits)
+    {
+        CHECK(remaining <= 100ms);
+        CHECK(remaining > 0ms);
+    }
+}
+
+TEST_CASE(rundown_loop_waits_are_rounded_up_to_the_deadline)
+{
+    fake_clock::s_now = {};
+    fake_queue queue;
+    CHECK(!queue.run(0ms));
+    CHECK(queue.waits.empty());
+
+    fake_clock::s_now = {};
+    CHECK(!win32app::run_until_quit<fake_clock>(
+        fake_clock::time_point{1500us}, [] { return false; },
+        [&](std::chrono::milliseconds remaining) {
+            queue.waits.push_back(remaining);
+            fake_clock::s_now += remaining;
+        }));
+    CHECK((queue.waits == std::vector<std::chrono::milliseconds>{2ms}));
+}
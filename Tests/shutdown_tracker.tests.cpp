@@ -0,0 +1,100 @@
+#include "test_harness.h"
+
+#include <win32app/shutdown_tracker.h>
+
+#include <chrono>
+#include <thread>
+#include <utility>
+
+using namespace std::chrono_literals;
+
+TEST_CASE(shutdown_tracker_counts_outstanding_operations)
+{
+    win32app::shutdown_tracker tracker;
+    auto first = tracker.track("first");
+    {
+        auto second = tracker.track("second", 7);
+        CHECK(tracker.outstanding() == 2);
+    }
+    CHECK(tracker.outstanding() == 1);
+
+    auto moved = std::move(first); // moves transfer the operation
+    CHECK(!first);
+    CHECK(moved);
+    CHECK(tracker.outstanding() == 1);
+    moved.reset();
+    moved.reset();
+    CHECK(tracker.outstanding() == 0);
+}
+
+TEST_CASE(shutdown_tracker_reports_stragglers_oldest_first)
+{
+    win32app::shutdown_tracker tracker;
+    auto released = tracker.track("released");
+    auto older = tracker.track("older", 1);
+    std::this_thread::sleep_for(1ms);
+    auto newer = tracker.track("newer", 2); // reuses no slot, released is still tracked
+    released.reset();
+
+    const auto report = tracker.wait_for(5ms);
+    CHECK(!report.completed);
+    CHECK(report.waited >= 5ms);
+    CHECK(report.stragglers.size() == 2);
+    CHECK(report.stragglers[0].name == "older");
+    CHECK(report.stragglers[0].thread == 1);
+    CHECK(report.stragglers[1].name == "newer");
+    CHECK(report.stragglers[1].thread == 2);
+    CHECK(report.stragglers[0].age > report.stragglers[1].age);
+    CHECK(!tracker.shutdown_latency());
+}
+
+TEST_CASE(shutdown_tracker_reuses_released_slots)
+{
+    win32app::shutdown_tracker tracker;
+    for (int i = 0; i < 100; i++)
+    {
+        auto token = tracker.track("operation");
+    }
+    auto token = tracker.track("last");
+    const auto stragglers = tracker.stragglers();
+    CHECK(stragglers.size() == 1);
+    CHECK(stragglers[0].name == "last");
+    CHECK(stragglers[0].thread == 0);
+}
+
+TEST_CASE(shutdown_tracker_measures_latency_from_begin_shutdown)
+{
+    win32app::shutdown_tracker tracker;
+    auto token = tracker.track("window");
+    CHECK(!tracker.is_shutting_down());
+    tracker.begin_shutdown();
+    CHECK(tracker.is_shutting_down());
+    CHECK(!tracker.shutdown_latency());
+
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(2ms);
+        token.reset();
+    });
+    const auto report = tracker.wait_for(10s);
+    releaser.join();
+    CHECK(report.completed);
+    CHECK(report.stragglers.empty());
+    CHECK(tracker.shutdown_latency().has_value());
+    CHECK(*tracker.shutdown_latency() == report.waited);
+    CHECK(report.waited >= 2ms);
+
+    // Started during shutdown, the shutdown is not done until it is released.
+    auto late = tracker.track("late");
+    CHECK(!tracker.shutdown_latency());
+    late.reset();
+    CHECK(tracker.shutdown_latency().has_value());
+}
+
+TEST_CASE(shutdown_tracker_completes_immediately_with_nothing_outstanding)
+{
+    win32app::shutdown_tracker tracker;
+    const auto report = tracker.wait_for(0ms);
+    CHECK(report.completed);
+    CHECK(report.waited == 0ns);
+    CHECK(tracker.shutdown_latency() == std::optional<std::chrono::nanoseconds>(0ns));
+}
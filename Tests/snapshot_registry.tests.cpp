@@ -0,0 +1,96 @@
+#include "test_harness.h"
+
+#include <win32app/snapshot_registry.h>
+
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST_CASE(snapshot_registry_adds_and_removes)
+{
+    win32app::snapshot_registry<int> registry;
+    CHECK(registry.snapshot()->empty());
+
+    const auto one = registry.add(1);
+    const auto two = registry.add(2);
+    const auto before = registry.snapshot();
+    registry.remove(one);
+    CHECK((*before == std::vector<int>{1, 2})); // snapshots are immutable
+    CHECK((*registry.snapshot() == std::vector<int>{2}));
+
+    const auto three = registry.add(3); // reuses the free slot
+    CHECK(three == one);
+    CHECK((*registry.snapshot() == std::vector<int>{3, 2}));
+    registry.remove(two);
+    registry.remove(three);
+    CHECK(registry.snapshot()->empty());
+}
+
+// Writers add and remove their own values while readers check every snapshot they see.
+TEST_CASE(snapshot_registry_stress)
+{
+    win32app::snapshot_registry<int> registry;
+    constexpr int writers = 4;
+    constexpr int rounds = 5000;
+    std::atomic<bool> done{};
+    std::atomic<size_t> snapshots{};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++)
+    {
+        readers.emplace_back([&] {
+            while (!done)
+            {
+                const auto snapshot = registry.snapshot();
+                std::set<int> unique(snapshot->begin(), snapshot->end());
+                CHECK(unique.size() == snapshot->size());       // no value twice, the free list has no duplicates
+                CHECK(snapshot->size() <= writers * 3);          // each writer holds at most 3 values
+                snapshots++;
+            }
+        });
+    }
+
+    std::vector<std::thread> threads;
+    for (int writer = 0; writer < writers; writer++)
+    {
+        threads.emplace_back([&, writer] {
+            std::vector<win32app::snapshot_registry<int>::handle> handles;
+            for (int round = 0; round < rounds; round++)
+            {
+                handles.push_back(registry.add(writer * rounds * 3 + round));
+                if (handles.size() == 3)
+                {
+                    registry.remove(handles[round % 3]);
+                    handles.erase(handles.begin() + (round % 3));
+                }
+            }
+            for (auto handle : handles)
+            {
+                registry.remove(handle);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    done = true;
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    CHECK(registry.snapshot()->empty());
+    CHECK(snapshots > 0);
+
+    // Every slot is free once, adding as many values as there were at most reuses them all with distinct handles.
+    std::set<win32app::snapshot_registry<int>::handle> handles;
+    for (int i = 0; i < writers * 3; i++)
+    {
+        handles.insert(registry.add(i));
+    }
+    CHECK(handles.size() == writers * 3);
+    CHECK(*handles.rbegin() < writers * 3);
+}
@@ -0,0 +1,100 @@
+#include "test_harness.h"
+
+#include <win32app/startup_trace.h>
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+const char* const c_names[]{"zero", "one", "two", "three"};
+
+// Event i has c_names[i % 4], start i and duration 2 * i, so a torn read does not match.
+void record_numbered(win32app::trace_ring& ring, int64_t first, int64_t count)
+{
+    for (auto i = first; i < first + count; i++)
+    {
+        ring.record(c_names[i % 4], i, 2 * i);
+    }
+}
+
+bool is_numbered(const win32app::trace_event& event)
+{
+    return (event.name == c_names[event.start_ns % 4]) && (event.duration_ns == 2 * event.start_ns);
+}
+} // namespace
+
+TEST_CASE(trace_ring_keeps_the_most_recent_events_in_order)
+{
+    auto ring = std::make_unique<win32app::trace_ring>(1);
+    CHECK(ring->events().empty());
+
+    record_numbered(*ring, 0, 10);
+    auto events = ring->events();
+    CHECK(events.size() == 10);
+    CHECK(events.front().start_ns == 0);
+
+    constexpr auto capacity = static_cast<int64_t>(win32app::trace_ring::c_capacity);
+    record_numbered(*ring, 10, 2 * capacity + 5);
+    events = ring->events();
+    CHECK(events.size() == win32app::trace_ring::c_capacity);
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        CHECK(events[i].start_ns == capacity + 15 + static_cast<int64_t>(i));
+        CHECK(is_numbered(events[i]));
+    }
+}
+
+// The reader must not see an event twice, or a mix of two events, while the writer wraps the ring.
+TEST_CASE(trace_ring_reads_while_written)
+{
+    auto ring = std::make_unique<win32app::trace_ring>(1);
+    std::atomic<bool> done{};
+    std::thread writer([&] {
+        record_numbered(*ring, 0, 200000);
+        done = true;
+    });
+
+    size_t reads = 0;
+    bool ordered = true;
+    bool consistent = true;
+    while (!done || (reads == 0))
+    {
+        const auto events = ring->events();
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            ordered = ordered && ((i == 0) || (events[i].start_ns > events[i - 1].start_ns));
+            consistent = consistent && is_numbered(events[i]);
+        }
+        reads++;
+    }
+    writer.join();
+    CHECK(ordered);
+    CHECK(consistent);
+    CHECK(ring->events().size() == win32app::trace_ring::c_capacity);
+}
+
+TEST_CASE(trace_log_writes_chrome_trace)
+{
+    auto& log = win32app::trace_log::instance();
+    std::thread([&] {
+        log.set_thread_name("test \"thread\"");
+        log.record("test event\n", 1500, 2250);
+        {
+            const win32app::trace_scope scope("test scope");
+        }
+    }).join();
+
+    std::ostringstream out;
+    log.write_chrome_trace(out);
+    const auto trace = out.str();
+    CHECK(trace.rfind("{\"traceEvents\":[", 0) == 0);
+    CHECK(trace.find(R"("args":{"name":"test \"thread\""}})") != std::string::npos);
+    CHECK(trace.find(R"({"name":"test event\u000a","cat":"win32app","ph":"X","pid":1,"tid":)") != std::string::npos);
+    CHECK(trace.find(R"(,"ts":1.500,"dur":2.250})") != std::string::npos);
+    CHECK(trace.find(R"({"name":"test scope")") != std::string::npos);
+    CHECK(trace.ends_with("\n],\"displayTimeUnit\":\"ms\"}\n"));
+}
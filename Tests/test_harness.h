@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdio>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// test_harness
+//
+// A minimal test runner for the portable headers, those that have no dependency on the Windows
+// headers, so their behavior is checked on any platform. Each *.tests.cpp file defines tests with
+// TEST_CASE and checks with CHECK, portable_tests.cpp runs them.
+//
+//    TEST_CASE(resource_cache_creates_once)
+//    {
+//        CHECK(cache.stats().misses == 1);
+//    }
+
+namespace win32app::tests
+{
+struct test_case
+{
+    std::string_view name;
+    void (*run)();
+};
+
+inline std::vector<test_case>& registered_tests()
+{
+    static std::vector<test_case> s_tests;
+    return s_tests;
+}
+
+inline int& failed_checks()
+{
+    static int s_failed{};
+    return s_failed;
+}
+
+struct test_registration
+{
+    test_registration(std::string_view name, void (*run)())
+    {
+        registered_tests().push_back({name, run});
+    }
+};
+
+inline void check_failed(const char* expression, const char* file, int line)
+{
+    std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", file, line, expression);
+    failed_checks()++;
+}
+} // namespace win32app::tests
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static const win32app::tests::test_registration name##_registration{#name, name}; \
+    static void name()
+
+#define CHECK(expression) \
+    do \
+    { \
+        if (!(expression)) \
+        { \
+            win32app::tests::check_failed(#expression, __FILE__, __LINE__); \
+        } \
+    } while (false)
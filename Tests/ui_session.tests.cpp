@@ -0,0 +1,128 @@
+#include "test_harness.h"
+
+#include <win32app/ui_session.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Records the calls, the window is an int and run() calls fn unless skipRun is set.
+struct fake_backend
+{
+    std::vector<std::string>* calls;
+    bool skipRun{};
+    bool throwOnDestroy{};
+    int* logged{};
+
+    void start_thread()
+    {
+        calls->push_back("start_thread");
+    }
+
+    void stop_thread()
+    {
+        calls->push_back("stop_thread");
+    }
+
+    void create_window()
+    {
+        calls->push_back("create_window");
+    }
+
+    void destroy_window()
+    {
+        calls->push_back("destroy_window");
+        if (throwOnDestroy)
+        {
+            throw std::runtime_error("destroy_window");
+        }
+    }
+
+    void reset_content()
+    {
+        calls->push_back("reset_content");
+    }
+
+    template <typename Fn>
+    void run(Fn&& fn)
+    {
+        if (!skipRun)
+        {
+            int window = 0;
+            fn(window);
+        }
+    }
+
+    void log_current_exception() noexcept
+    {
+        (*logged)++;
+    }
+};
+} // namespace
+
+TEST_CASE(ui_session_reuses_the_thread_and_window)
+{
+    std::vector<std::string> calls;
+    {
+        win32app::ui_session<fake_backend> session(fake_backend{&calls});
+        session.run([](int&) {});
+        session.run([](int&) {});
+        CHECK(session.stats().calls == 2);
+        CHECK(session.stats().thread_starts == 1);
+        CHECK(session.stats().window_creates == 1);
+    }
+    CHECK((calls == std::vector<std::string>{"start_thread", "create_window", "reset_content", "reset_content", "destroy_window", "stop_thread"}));
+}
+
+TEST_CASE(ui_session_without_keep_window_recreates_the_window)
+{
+    std::vector<std::string> calls;
+    win32app::ui_session<fake_backend> session(fake_backend{&calls}, {false});
+    session.run([](int&) {});
+    session.run([](int&) {});
+    CHECK(session.stats().thread_starts == 1);
+    CHECK(session.stats().window_creates == 2);
+}
+
+TEST_CASE(ui_session_run_time_is_zero_when_fn_is_not_called)
+{
+    std::vector<std::string> calls;
+    win32app::ui_session<fake_backend> session(fake_backend{&calls, true});
+    session.run([](int&) {});
+    CHECK(session.stats().total_run_time == std::chrono::nanoseconds{});
+    CHECK(session.stats().last_overhead < std::chrono::seconds(1));
+}
+
+TEST_CASE(ui_session_restarts_after_fn_throws)
+{
+    std::vector<std::string> calls;
+    win32app::ui_session<fake_backend> session(fake_backend{&calls});
+    bool threw = false;
+    try
+    {
+        session.run([](int&) { throw std::runtime_error("fn"); });
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(!session.is_running());
+    session.run([](int&) {});
+    CHECK(session.stats().thread_starts == 2);
+}
+
+TEST_CASE(ui_session_destructor_logs_and_stops_the_thread_when_stopping_fails)
+{
+    std::vector<std::string> calls;
+    int logged = 0;
+    {
+        win32app::ui_session<fake_backend> session(fake_backend{&calls, false, true, &logged});
+        session.run([](int&) {});
+    }
+    CHECK(logged == 1);
+    CHECK(calls.back() == "stop_thread");
+}
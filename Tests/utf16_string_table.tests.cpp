@@ -0,0 +1,45 @@
+#include "test_harness.h"
+
+#include <win32app/utf16_string_table.h>
+
+#include <string>
+#include <vector>
+
+TEST_CASE(utf16_string_table_splits_and_converts)
+{
+    const auto entries = win32app::split_utf8_blob("OK\ncaf\xC3\xA9\n\n\xF0\x9F\x98\x80\n", '\n');
+    CHECK(entries.size() == 4);
+
+    const auto table = win32app::make_utf16_string_table<char16_t>(entries);
+    CHECK(table.has_value());
+    CHECK(table->size() == 4);
+    CHECK((*table)[0] == u"OK");
+    CHECK((*table)[1] == u"caf\u00E9");
+    CHECK((*table)[2].empty());
+    CHECK((*table)[3] == u"\U0001F600");
+    CHECK(table->c_str(1)[4] == u'\0');
+}
+
+TEST_CASE(utf16_string_table_same_result_on_many_threads)
+{
+    std::string blob;
+    for (int i = 0; i < 40000; i++)
+    {
+        blob += "entry " + std::to_string(i) + " \xE7\xAA\x97\xE5\x8F\xA3 \xF0\x9F\x98\x80\n"; // about 1.2 MB, several threads worth
+    }
+    const auto entries = win32app::split_utf8_blob(blob, '\n');
+    const auto single = win32app::make_utf16_string_table<char16_t>(entries, 1);
+    const auto parallel = win32app::make_utf16_string_table<char16_t>(entries, 4);
+    CHECK(single && parallel);
+    CHECK(single->m_text == parallel->m_text);
+    CHECK(single->m_offsets == parallel->m_offsets);
+    CHECK((*parallel)[39999] == u"entry 39999 \u7A97\u53E3 \U0001F600");
+}
+
+TEST_CASE(utf16_string_table_rejects_invalid_entries)
+{
+    std::vector<std::string_view> entries(100000, "valid");
+    entries[77777] = "\xC3";
+    CHECK(!win32app::make_utf16_string_table<char16_t>(entries, 4));
+    CHECK(!win32app::make_utf16_string_table<char16_t>(entries, 1));
+}
@@ -0,0 +1,230 @@
+#include "test_harness.h"
+
+#include <win32app/utf8_validation.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+// A straightforward decoder, checked against validate_utf8 on random input.
+struct reference_result
+{
+    bool valid{true};
+    bool ascii_only{true};
+    size_t error_offset{};
+    std::u16string utf16;
+};
+
+reference_result reference_decode(std::string_view text)
+{
+    reference_result result;
+    result.error_offset = text.size();
+    size_t i = 0;
+    while (i < text.size())
+    {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        if (lead < 0x80)
+        {
+            result.utf16.push_back(lead);
+            i++;
+            continue;
+        }
+        result.ascii_only = false;
+
+        size_t length = 0;
+        char32_t codePoint{};
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+            codePoint = lead & 0x1F;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+            codePoint = lead & 0x0F;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+            codePoint = lead & 0x07;
+        }
+
+        bool valid = (length != 0) && (i + length <= text.size());
+        for (size_t j = 1; valid && (j < length); j++)
+        {
+            const auto next = static_cast<unsigned char>(text[i + j]);
+            valid = (next & 0xC0) == 0x80;
+            codePoint = (codePoint << 6) | (next & 0x3F);
+        }
+        constexpr char32_t c_minimum[]{0, 0, 0x80, 0x800, 0x10000};
+        if (!valid || (codePoint < c_minimum[length]) || (codePoint > 0x10FFFF) || ((codePoint >= 0xD800) && (codePoint <= 0xDFFF)))
+        {
+            result.valid = false;
+            result.error_offset = i;
+            return result;
+        }
+
+        if (codePoint >= 0x10000)
+        {
+            result.utf16.push_back(static_cast<char16_t>(0xD800 + ((codePoint - 0x10000) >> 10)));
+            result.utf16.push_back(static_cast<char16_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF)));
+        }
+        else
+        {
+            result.utf16.push_back(static_cast<char16_t>(codePoint));
+        }
+        i += length;
+    }
+    return result;
+}
+
+void append_utf8(std::string& out, char32_t codePoint)
+{
+    if (codePoint < 0x80)
+    {
+        out.push_back(static_cast<char>(codePoint));
+    }
+    else if (codePoint < 0x800)
+    {
+        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+// Mostly well formed text with runs of ASCII long enough for the vectorized scan, then a few bytes changed.
+std::string make_random_text(std::mt19937& rng)
+{
+    std::string text;
+    const auto codePoints = rng() % 80;
+    for (size_t i = 0; i < codePoints; i++)
+    {
+        switch (rng() % 6)
+        {
+        case 0:
+            text.append(rng() % 40, 'a');
+            break;
+        case 1:
+            append_utf8(text, 0x80 + rng() % (0x800 - 0x80));
+            break;
+        case 2:
+            append_utf8(text, 0x800 + rng() % (0x10000 - 0x800)); // includes surrogates, which are invalid
+            break;
+        case 3:
+            append_utf8(text, 0x10000 + rng() % (0x110000 - 0x10000));
+            break;
+        default:
+            text.push_back(static_cast<char>(0x20 + rng() % 0x5F));
+            break;
+        }
+    }
+    for (auto mutations = rng() % 3; (mutations > 0) && !text.empty(); mutations--)
+    {
+        text[rng() % text.size()] = static_cast<char>(rng());
+    }
+    if (!text.empty() && ((rng() % 8) == 0))
+    {
+        text.pop_back(); // often truncates a sequence
+    }
+    return text;
+}
+
+void check_against_reference(std::string_view text)
+{
+    const auto expected = reference_decode(text);
+    const auto result = win32app::validate_utf8(text);
+    CHECK(result.valid == expected.valid);
+    CHECK(result.ascii_only == expected.ascii_only);
+    CHECK(result.error_offset == expected.error_offset);
+    if (expected.valid)
+    {
+        CHECK(result.utf16_length == expected.utf16.size());
+        std::u16string converted(result.utf16_length, u'\0');
+        win32app::details::utf8_to_utf16_unchecked(text, converted.data());
+        CHECK(converted == expected.utf16);
+    }
+}
+} // namespace
+
+TEST_CASE(utf8_validation_matches_reference_on_random_text)
+{
+    std::mt19937 rng(28);
+    for (int i = 0; i < 200000; i++)
+    {
+        const auto text = make_random_text(rng);
+        const auto offset = rng() % 16; // unaligned starts for the vectorized scan
+        const auto padded = std::string(offset, 'x') + text;
+        check_against_reference(std::string_view(padded).substr(offset));
+    }
+}
+
+TEST_CASE(utf8_validation_matches_reference_on_random_bytes)
+{
+    std::mt19937 rng(29);
+    std::string text;
+    for (int i = 0; i < 200000; i++)
+    {
+        text.resize(rng() % 24);
+        for (auto& ch : text)
+        {
+            ch = static_cast<char>(rng());
+        }
+        check_against_reference(text);
+    }
+}
+
+TEST_CASE(utf8_validation_matches_reference_on_long_multi_byte_text)
+{
+    // Many 16 byte blocks with few ASCII runs, for the block check and its hand over at the end of the blocks.
+    std::mt19937 rng(30);
+    for (int i = 0; i < 20000; i++)
+    {
+        std::string text;
+        const auto codePoints = rng() % 200;
+        for (size_t j = 0; j < codePoints; j++)
+        {
+            constexpr char32_t c_starts[]{0x20, 0x80, 0x800, 0xE000, 0x10000};
+            const auto range = rng() % 4;
+            append_utf8(text, c_starts[range] + rng() % (c_starts[range + 1] - c_starts[range]));
+        }
+        if (!text.empty() && ((rng() % 2) == 0))
+        {
+            text[rng() % text.size()] = static_cast<char>(rng());
+        }
+        if (!text.empty() && ((rng() % 4) == 0))
+        {
+            text.resize(rng() % text.size());
+        }
+        check_against_reference(text);
+    }
+}
+
+TEST_CASE(utf8_validation_boundaries)
+{
+    // U+007F, U+0080, U+07FF, U+0800, U+FFFF, U+10000, U+10FFFF
+    const auto valid = win32app::validate_utf8("\x7F\xC2\x80\xDF\xBF\xE0\xA0\x80\xEF\xBF\xBF\xF0\x90\x80\x80\xF4\x8F\xBF\xBF");
+    CHECK(valid.valid);
+    CHECK(!valid.ascii_only);
+    CHECK(valid.utf16_length == 9);
+
+    CHECK(!win32app::validate_utf8("\xC0\x80").valid);         // overlong
+    CHECK(!win32app::validate_utf8("\xE0\x9F\xBF").valid);     // overlong
+    CHECK(!win32app::validate_utf8("\xED\xA0\x80").valid);     // surrogate
+    CHECK(!win32app::validate_utf8("\xF4\x90\x80\x80").valid); // past U+10FFFF
+    CHECK(win32app::validate_utf8("0123456789abcdef0123456789\xE2\x82").error_offset == 26);
+    CHECK(win32app::validate_utf8("0123456789abcdef").ascii_only);
+}
@@ -0,0 +1,218 @@
+#include "test_harness.h"
+
+#include <win32app/window_index.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+// The windows that exist, changed by the replayed events. Posting an event and reading the attributes in
+// query() plays the part of the window event hook and the Win32 calls in LiveWindowIndex.
+struct fake_desktop
+{
+    std::map<uint64_t, win32app::window_attributes> windows;
+    size_t queries{};
+
+    bool query(uint64_t handle, uint8_t events, win32app::window_attributes& attributes)
+    {
+        queries++;
+        const auto found = windows.find(handle);
+        if (found == windows.end())
+        {
+            return false;
+        }
+        if (events & win32app::window_event_reads::styles)
+        {
+            attributes.style = found->second.style;
+            attributes.exStyle = found->second.exStyle;
+        }
+        if (events & win32app::window_event_reads::rect)
+        {
+            attributes.rect = found->second.rect;
+        }
+        if (events & win32app::window_event_reads::owner)
+        {
+            attributes.owner = found->second.owner;
+        }
+        if (events & win32app::window_event_reads::title)
+        {
+            attributes.title = found->second.title;
+        }
+        return true;
+    }
+};
+
+bool same(const win32app::window_attributes& left, const win32app::window_attributes& right)
+{
+    return (left.style == right.style) && (left.exStyle == right.exStyle) && (left.rect == right.rect) && (left.owner == right.owner) &&
+           (left.title == right.title);
+}
+
+bool index_matches(const win32app::window_index& index, const fake_desktop& desktop)
+{
+    if (index.size() != desktop.windows.size())
+    {
+        return false;
+    }
+    for (const auto& [handle, attributes] : desktop.windows)
+    {
+        const auto indexed = index.find(handle);
+        if (!indexed || !same(*indexed, attributes))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr uint32_t c_visible = win32app::window_style::visible;
+} // namespace
+
+TEST_CASE(window_event_queue_coalesces_per_window)
+{
+    win32app::window_event_queue queue;
+    CHECK(queue.post(1, win32app::window_created));
+    CHECK(!queue.post(2, win32app::window_created));
+    CHECK(!queue.post(1, win32app::window_location_changed));
+    CHECK(!queue.post(1, win32app::window_location_changed));
+    CHECK(!queue.post(2, win32app::window_destroyed));
+    CHECK(!queue.post(2, win32app::window_name_changed)); // the handle was reused
+    CHECK(queue.pending() == 2);
+    CHECK(queue.posted() == 6);
+
+    const auto batch = queue.take();
+    CHECK(batch.size() == 2);
+    CHECK((batch[0].handle == 1) && (batch[0].events == (win32app::window_created | win32app::window_location_changed)));
+    CHECK((batch[1].handle == 2) && (batch[1].events == (win32app::window_created | win32app::window_name_changed)));
+    CHECK(queue.pending() == 0);
+    CHECK(queue.post(3, win32app::window_shown)); // first of the next batch
+}
+
+TEST_CASE(window_index_reports_added_removed_and_changed)
+{
+    fake_desktop desktop;
+    desktop.windows[1] = {c_visible, 0, {0, 0, 100, 100}, 0, L"one"};
+    desktop.windows[2] = {c_visible, 0, {0, 0, 50, 50}, 0, L"two"};
+    win32app::window_index index;
+    std::vector<win32app::window_index_changes> notified;
+    const auto id = index.subscribe([&](const win32app::window_index_changes& changes) { notified.push_back(changes); });
+    const auto query = [&](uint64_t handle, uint8_t events, win32app::window_attributes& attributes) { return desktop.query(handle, events, attributes); };
+
+    const win32app::pending_window_events created[] = {{1, win32app::window_created}, {2, win32app::window_created}};
+    auto changes = index.apply(created, query);
+    CHECK((changes.added == std::vector<uint64_t>{1, 2}));
+    CHECK(index_matches(index, desktop));
+
+    // A location event for a window that did not move is not a change, and nobody is notified.
+    const win32app::pending_window_events unmoved[] = {{1, win32app::window_location_changed}};
+    CHECK(index.apply(unmoved, query).empty());
+    CHECK(notified.size() == 1);
+
+    desktop.windows[1].rect = {10, 10, 110, 110};
+    desktop.windows.erase(2);
+    const win32app::pending_window_events moved[] = {{1, win32app::window_location_changed}, {2, win32app::window_destroyed}, {3, win32app::window_destroyed}};
+    changes = index.apply(moved, query);
+    CHECK((changes.changed == std::vector<uint64_t>{1}));
+    CHECK((changes.removed == std::vector<uint64_t>{2}));
+    CHECK(changes.added.empty());
+    CHECK(index_matches(index, desktop));
+    CHECK(notified.size() == 2);
+
+    // Only the attributes the events select are read, a name change does not pick up a move.
+    desktop.windows[1].rect = {20, 20, 120, 120};
+    desktop.windows[1].title = L"renamed";
+    const win32app::pending_window_events renamed[] = {{1, win32app::window_name_changed}};
+    index.apply(renamed, query);
+    CHECK(notified.size() == 3);
+    CHECK(index.find(1)->title == L"renamed");
+    CHECK((index.find(1)->rect == win32app::layout_rect{10, 10, 110, 110}));
+
+    index.unsubscribe(id);
+    desktop.windows.erase(1);
+    const win32app::pending_window_events gone[] = {{1, win32app::window_shown}}; // the window is gone before the batch is applied
+    CHECK((index.apply(gone, query).removed == std::vector<uint64_t>{1}));
+    CHECK(notified.size() == 3);
+    CHECK(index.size() == 0);
+    CHECK(index.batches() == 5);
+}
+
+// Replays a deterministic stream of window events, with batches taken at random points, and checks that the
+// index matches the desktop after every batch and that coalescing reduced the number of windows read.
+TEST_CASE(window_index_replays_an_event_stream)
+{
+    fake_desktop desktop;
+    win32app::window_event_queue queue;
+    win32app::window_index index;
+    size_t added{}, removed{};
+    index.subscribe([&](const win32app::window_index_changes& changes) {
+        added += changes.added.size();
+        removed += changes.removed.size();
+    });
+
+    std::mt19937 rng(45);
+    size_t batches{};
+    size_t flushRequests{};
+    for (int step = 0; step < 20000; step++)
+    {
+        const uint64_t handle = 1 + rng() % 64; // handles are reused
+        const auto existing = desktop.windows.find(handle);
+        uint8_t event;
+        if (existing == desktop.windows.end())
+        {
+            const auto left = static_cast<int32_t>(rng() % 1000);
+            desktop.windows[handle] = {(rng() % 4) ? c_visible : 0u, 0, {left, 0, left + 200, 150}, 0, L"window " + std::to_wstring(handle)};
+            event = win32app::window_created;
+        }
+        else
+        {
+            auto& window = existing->second;
+            switch (rng() % 8)
+            {
+            case 0:
+                desktop.windows.erase(existing);
+                event = win32app::window_destroyed;
+                break;
+            case 1:
+                window.style ^= c_visible;
+                event = (window.style & c_visible) ? win32app::window_shown : win32app::window_hidden;
+                break;
+            case 2:
+                window.style ^= win32app::window_style::minimized;
+                event = win32app::window_style_changed;
+                break;
+            case 3:
+                window.title += L"*";
+                event = win32app::window_name_changed;
+                break;
+            default: // drags report the most events
+                window.rect.left += 1;
+                window.rect.right += 1;
+                event = win32app::window_location_changed;
+                break;
+            }
+        }
+
+        flushRequests += queue.post(handle, event) ? 1 : 0;
+        if ((rng() % 500) == 0)
+        {
+            index.apply(queue.take(), [&](uint64_t queried, uint8_t events, win32app::window_attributes& attributes) {
+                return desktop.query(queried, events, attributes);
+            });
+            batches++;
+            CHECK(index_matches(index, desktop));
+        }
+    }
+    index.apply(queue.take(), [&](uint64_t queried, uint8_t events, win32app::window_attributes& attributes) {
+        return desktop.query(queried, events, attributes);
+    });
+    CHECK(index_matches(index, desktop));
+    CHECK(added - removed == desktop.windows.size());
+    CHECK(index.batches() == batches + 1);
+    CHECK(flushRequests <= batches + 1);
+    CHECK(queue.posted() == 20000);
+    CHECK(desktop.queries < queue.posted() / 4);
+}
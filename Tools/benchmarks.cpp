@@ -0,0 +1,1011 @@
+// benchmarks
+//
+// Benchmarks for the hot paths of the library, to track regressions from release to release. Each
+// benchmark runs a fixed amount of work (items) repeatedly for at least --min-time and reports the
+// median and best time per item. Results are written as JSON to stdout (or --json file), a readable
+// table goes to stderr.
+//
+//    benchmarks                          all benchmarks
+//    benchmarks --filter layout          the benchmarks whose name contains "layout"
+//    benchmarks --min-time 500 --json results.json
+//
+// The portable headers are measured on any platform, and message dispatch too, through win32_shim.h where
+// there are no Windows headers. UTF-8 conversion through MultiByteToWideChar and LogWindow ingestion and
+// export need Windows and are only built there. Benchmarks.vcxproj builds this on Windows. The time to the
+// first XamlHostWindow, with and without Prewarm, also needs C++/WinRT and a manifest that enables
+// Xaml islands, it is built when WIN32APP_BENCHMARK_XAML is defined:
+//    cl /std:c++20 /O2 /EHsc /await:strict /DWIN32APP_BENCHMARK_XAML /I..\inc benchmarks.cpp WindowsApp.lib
+//       /link /MANIFEST:EMBED /MANIFESTINPUT:..\Samples\win32_app.manifest
+//
+// This is portable C++20, build it optimized, for example
+//    cl /std:c++20 /O2 /EHsc /I..\inc benchmarks.cpp
+//    g++ -std=c++20 -O2 -pthread -I../inc benchmarks.cpp -o benchmarks
+// and add -mssse3 (/arch:AVX) to measure the vectorized UTF-8 validation, see utf8_validation.h.
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <commctrl.h>
+#include <wil/resource.h>
+#include <win32app/win32_app_helpers.h>
+#include <win32app/utf8_helpers.h>
+#include <win32app/LogWindow.h>
+#pragma comment(lib, "comctl32.lib")
+#if defined(WIN32APP_BENCHMARK_XAML)
+#include <win32app/XamlHostWindow.h>
+#endif
+#else
+#include "win32_shim.h"
+#include <win32app/message_dispatch.h>
+#endif
+
+#include <win32app/anchor_layout.h>
+#include <win32app/compressed_resource.h>
+#include <win32app/constraint_layout.h>
+#include <win32app/embedded_resources.h>
+#include <win32app/reference_waiter.h>
+#include <win32app/resize_throttle.h>
+#include <win32app/startup_trace.h>
+#include <win32app/string_pool.h>
+#include <win32app/ui_thread_placement.h>
+#include <win32app/utf16_string_table.h>
+#include <win32app/utf8_validation.h>
+#include <win32app/window_index.h>
+#include <win32app/window_snapshot.h>
+#include <win32app/work_stealing_pool.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+struct benchmark_result
+{
+    std::string name;
+    size_t items;          // work per run
+    size_t runs;
+    double median_ns;      // per item
+    double best_ns;        // per item
+};
+
+struct benchmark_options
+{
+    std::string filter;
+    std::chrono::milliseconds minTime{200};
+};
+
+// Keeps the compiler from removing work whose result is otherwise unused, the result is read through a volatile.
+std::atomic<unsigned int> g_sink{0};
+
+template <typename T>
+void keep(const T& value)
+{
+    g_sink.fetch_add(*reinterpret_cast<const volatile unsigned char*>(&value), std::memory_order_relaxed);
+}
+
+struct benchmark_runner
+{
+    explicit benchmark_runner(benchmark_options options) : m_options(std::move(options))
+    {
+    }
+
+    // run() does items units of work, it is called once to warm up and then until minTime has passed.
+    void add(std::string name, size_t items, const std::function<void()>& run)
+    {
+        add_timed(std::move(name), items, [&] {
+            const auto runStart = clock_type::now();
+            run();
+            return clock_type::now() - runStart;
+        });
+    }
+
+    // Like add() for work that times itself, run() returns the time its items took.
+    void add_timed(std::string name, size_t items, const std::function<clock_type::duration()>& run)
+    {
+        if (!m_options.filter.empty() && (name.find(m_options.filter) == std::string::npos))
+        {
+            return;
+        }
+
+        run(); // warm up, first touch of memory and lazy initialization
+        std::vector<double> samples;
+        const auto start = clock_type::now();
+        do
+        {
+            const auto elapsed = std::chrono::duration<double, std::nano>(run()).count();
+            samples.push_back(elapsed / static_cast<double>(items));
+        } while (((clock_type::now() - start) < m_options.minTime) || (samples.size() < 3));
+
+        std::sort(samples.begin(), samples.end());
+        m_results.push_back({std::move(name), items, samples.size(), samples[samples.size() / 2], samples.front()});
+        const auto& result = m_results.back();
+        std::fprintf(stderr, "%-48s %12.2f ns/item %12.2f best %8zu runs\n", result.name.c_str(), result.median_ns, result.best_ns, result.runs);
+    }
+
+    void write_json(std::ostream& out) const
+    {
+        out << "{\"schema\":1,\"platform\":\"" << platform() << "\",\"hardware_concurrency\":" << std::thread::hardware_concurrency()
+            << ",\"benchmarks\":[";
+        for (size_t i = 0; i < m_results.size(); i++)
+        {
+            const auto& result = m_results[i];
+            out << (i ? ",\n" : "\n") << "{\"name\":\"" << result.name << "\",\"items\":" << result.items << ",\"runs\":" << result.runs
+                << ",\"median_ns_per_item\":" << result.median_ns << ",\"best_ns_per_item\":" << result.best_ns << "}";
+        }
+        out << "\n]}\n";
+    }
+
+private:
+    static const char* platform()
+    {
+#if defined(_WIN32)
+        return "windows";
+#elif defined(__linux__)
+        return "linux";
+#else
+        return "other";
+#endif
+    }
+
+    benchmark_options m_options;
+    std::vector<benchmark_result> m_results;
+};
+
+std::string make_text(size_t size, bool asciiOnly, uint32_t seed)
+{
+    static constexpr std::string_view c_words[]{"window ", "layout ", "message ", "resource ", "thread "};
+    static constexpr std::string_view c_wide[]{"fen\xC3\xAAtre ", "\xE7\xAA\x97\xE5\x8F\xA3 ", "\xF0\x9F\x98\x80 "};
+    std::mt19937 rng(seed);
+    std::string text;
+    text.reserve(size + 16);
+    while (text.size() < size)
+    {
+        if (!asciiOnly && ((rng() % 4) == 0))
+        {
+            text += c_wide[rng() % std::size(c_wide)];
+        }
+        else
+        {
+            text += c_words[rng() % std::size(c_words)];
+        }
+    }
+    return text;
+}
+
+void add_utf8_benchmarks(benchmark_runner& runner)
+{
+    constexpr size_t size = 1024 * 1024;
+    const auto ascii = make_text(size, true, 1);
+    const auto mixed = make_text(size, false, 2);
+    runner.add("utf8/validate_ascii_1MB", ascii.size(), [&] { keep(win32app::validate_utf8(ascii)); });
+    runner.add("utf8/validate_mixed_1MB", mixed.size(), [&] { keep(win32app::validate_utf8(mixed)); });
+    // The portable counterpart of utf8/from_utf8_1MB, validation and the conversion the string table uses.
+    runner.add("utf8/transcode_mixed_1MB", mixed.size(), [&] {
+        const auto validation = win32app::validate_utf8(mixed);
+        std::wstring text(validation.utf16_length, L'\0');
+        win32app::details::utf8_to_utf16_unchecked(mixed, text.data());
+        keep(text.size());
+    });
+
+    const auto blob = make_text(size, false, 3);
+    std::vector<std::string_view> entries;
+    for (size_t offset = 0; offset + 64 <= blob.size();)
+    {
+        auto end = offset + 64;
+        while ((end < blob.size()) && ((static_cast<unsigned char>(blob[end]) & 0xC0) == 0x80))
+        {
+            end++; // keep code points whole
+        }
+        entries.push_back(std::string_view(blob).substr(offset, end - offset));
+        offset = end;
+    }
+    runner.add("utf8/string_table_" + std::to_string(entries.size()) + "_entries", entries.size(),
+        [&] { keep(win32app::make_utf16_string_table<wchar_t>(entries)); });
+    runner.add("utf8/string_table_" + std::to_string(entries.size()) + "_entries_1_thread", entries.size(),
+        [&] { keep(win32app::make_utf16_string_table<wchar_t>(entries, 1)); });
+    // The alternative to a table, a std::wstring per entry converted like from_utf8() does.
+    runner.add("utf8/wstring_per_entry_" + std::to_string(entries.size()) + "_entries", entries.size(), [&] {
+        std::vector<std::wstring> strings;
+        strings.reserve(entries.size());
+        for (auto entry : entries)
+        {
+            const auto validation = win32app::validate_utf8(entry);
+            auto& text = strings.emplace_back(validation.utf16_length, L'\0');
+            win32app::details::utf8_to_utf16_unchecked(entry, text.data());
+        }
+        keep(strings.size());
+    });
+#if defined(_WIN32)
+    runner.add("utf8/from_utf8_per_entry_" + std::to_string(entries.size()) + "_entries", entries.size(), [&] {
+        std::vector<std::wstring> strings;
+        strings.reserve(entries.size());
+        for (auto entry : entries)
+        {
+            strings.emplace_back(from_utf8(entry));
+        }
+        keep(strings.size());
+    });
+#endif
+
+    const auto compressed = win32app::make_compressed_resource(mixed);
+    const auto header = win32app::parse_compressed_resource_header(compressed);
+    runner.add("resource/lz4_decompress_1MB", mixed.size(), [&] { keep(win32app::decompress_resource(*header)); });
+
+    // The first use of a markup resource, what get_decoded_resource_view() does: the resource bytes are paged in
+    // (copied to freshly allocated memory here), decompressed when compressed and transcoded to UTF-16.
+    std::string markupResource;
+    for (uint32_t item = 0; markupResource.size() < 256 * 1024; item++)
+    {
+        markupResource += "<TextBlock x:Name=\"Item" + std::to_string(item) + "\" Text=\"" + make_text(40, false, item) + "\"/>\n";
+    }
+    const auto compressedMarkup = win32app::make_compressed_resource(markupResource);
+    auto coldStart = [&](std::string_view image) {
+        auto paged = std::make_unique<char[]>(image.size());
+        memcpy(paged.get(), image.data(), image.size());
+        std::string_view bytes{paged.get(), image.size()};
+        std::optional<std::string> decompressed;
+        if (auto resourceHeader = win32app::parse_compressed_resource_header(bytes))
+        {
+            decompressed = win32app::decompress_resource(*resourceHeader);
+            bytes = *decompressed;
+        }
+        const auto validation = win32app::validate_utf8(bytes);
+        std::wstring text(validation.utf16_length, L'\0');
+        win32app::details::utf8_to_utf16_unchecked(bytes, text.data());
+        keep(text[0]);
+    };
+    const auto suffix = "_" + std::to_string(markupResource.size() / 1024) + "KB_to_" + std::to_string(compressedMarkup.size() / 1024) + "KB";
+    runner.add("resource/cold_start_stored" + suffix, 1, [&] { coldStart(markupResource); });
+    runner.add("resource/cold_start_lz4" + suffix, 1, [&] { coldStart(compressedMarkup); });
+
+    // What the first window pays for its markup, per load, transcoding the UTF-8 resource at runtime (from_utf8 without
+    // the MultiByteToWideChar call) or looking it up in the table generated by Tools/embed_utf16_resources.cpp.
+    const auto markup = make_text(32 * 1024, false, 9);
+    const std::string_view markupEntries[]{markup};
+    const auto transcoded = win32app::make_utf16_string_table<wchar_t>(markupEntries);
+    const win32app::embedded_resource index[]{{L"AppWindow.xaml", 0, static_cast<uint32_t>((*transcoded)[0].size())}};
+    const win32app::embedded_resource_table table{index, 1, transcoded->c_str(0)};
+    runner.add("resource/startup_transcode_utf8_32KB", 1, [&] {
+        const auto validation = win32app::validate_utf8(markup);
+        std::wstring text(validation.utf16_length, L'\0');
+        win32app::details::utf8_to_utf16_unchecked(markup, text.data());
+        keep(text[0]);
+    });
+    runner.add("resource/startup_embedded_utf16_32KB", 1, [&] { keep(table.find(L"AppWindow.xaml").size()); });
+}
+
+// reference_waiter before it became an atomic count, a mutex and condition variable with a notification per
+// change, the baseline for the reference_waiter benchmarks.
+struct mutex_reference_waiter
+{
+    void wait_until_zero()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return m_count == 0; });
+    }
+
+    struct reference_waiter_holder
+    {
+        explicit reference_waiter_holder(mutex_reference_waiter& s) : m_s(s)
+        {
+            std::unique_lock<std::mutex> lock(m_s.m_mutex);
+            m_s.m_count++;
+            m_s.m_cv.notify_all();
+        }
+
+        ~reference_waiter_holder()
+        {
+            std::unique_lock<std::mutex> lock(m_s.m_mutex);
+            m_s.m_count--;
+            m_s.m_cv.notify_all();
+        }
+
+        reference_waiter_holder(const reference_waiter_holder&) = delete;
+        reference_waiter_holder& operator=(const reference_waiter_holder&) = delete;
+
+    private:
+        mutex_reference_waiter& m_s;
+    };
+
+    [[nodiscard]] reference_waiter_holder take_reference()
+    {
+        return reference_waiter_holder(*this);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    int m_count = 0;
+};
+
+// Threads that take and release references on a waiter. They are started by the first run and released for
+// each run by a start barrier, so a run times the take and release loop and not thread creation and join.
+template <typename TWaiter>
+struct contended_references
+{
+    contended_references(unsigned int threadCount, size_t perThread) : m_threadCount(threadCount), m_perThread(perThread)
+    {
+    }
+
+    ~contended_references()
+    {
+        m_stop = true;
+        m_generation.fetch_add(1, std::memory_order_release);
+        m_generation.notify_all();
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    contended_references(const contended_references&) = delete;
+    contended_references& operator=(const contended_references&) = delete;
+
+    // From the release of the threads to the end of the last one.
+    clock_type::duration run()
+    {
+        while (m_threads.size() < m_threadCount)
+        {
+            m_threads.emplace_back([this] { take_release(); });
+        }
+        m_remaining.store(m_threadCount);
+        const auto start = clock_type::now();
+        const auto generation = m_generation.fetch_add(1, std::memory_order_release) + 1;
+        m_generation.notify_all();
+        for (auto completed = m_completed.load(std::memory_order_acquire); completed != generation; completed = m_completed.load(std::memory_order_acquire))
+        {
+            m_completed.wait(completed);
+        }
+        m_waiter.wait_until_zero();
+        return m_end - start;
+    }
+
+private:
+    void take_release()
+    {
+        uint32_t generation = 0;
+        for (;;)
+        {
+            m_generation.wait(generation, std::memory_order_acquire);
+            generation = m_generation.load(std::memory_order_acquire);
+            if (m_stop)
+            {
+                return;
+            }
+            for (size_t i = 0; i < m_perThread; i++)
+            {
+                auto reference = m_waiter.take_reference();
+            }
+            const auto end = clock_type::now();
+            if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                m_end = end;
+                m_completed.store(generation, std::memory_order_release);
+                m_completed.notify_one();
+            }
+        }
+    }
+
+    TWaiter m_waiter;
+    const unsigned int m_threadCount;
+    const size_t m_perThread;
+    std::vector<std::thread> m_threads;
+    std::atomic<uint32_t> m_generation{};
+    std::atomic<uint32_t> m_completed{};
+    std::atomic<unsigned int> m_remaining{};
+    std::atomic<bool> m_stop{};
+    clock_type::time_point m_end{};
+};
+
+void add_threading_benchmarks(benchmark_runner& runner)
+{
+    // How each reference_waiter scales from 1 to 64 threads, more windows than most machines have cores.
+    for (const auto threadCount : {1u, 4u, 16u, 64u})
+    {
+        const size_t perThread = 1600000 / threadCount;
+        const auto suffix = "_" + std::to_string(threadCount) + "_threads";
+
+        contended_references<mutex_reference_waiter> baseline(threadCount, perThread);
+        runner.add_timed("mutex_reference_waiter/take_release" + suffix, threadCount * perThread, [&] { return baseline.run(); });
+        contended_references<reference_waiter> waiter(threadCount, perThread);
+        runner.add_timed("reference_waiter/take_release" + suffix, threadCount * perThread, [&] { return waiter.run(); });
+        contended_references<sharded_reference_waiter<>> sharded(threadCount, perThread);
+        runner.add_timed("sharded_reference_waiter/take_release" + suffix, threadCount * perThread, [&] { return sharded.run(); });
+    }
+
+    win32app::work_stealing_pool pool;
+    constexpr size_t tasks = 100000;
+    runner.add("work_stealing_pool/submit_run_100k", tasks, [&] {
+        std::atomic<size_t> remaining{tasks};
+        for (size_t i = 0; i < tasks; i++)
+        {
+            pool.submit([&] {
+                if (remaining.fetch_sub(1) == 1)
+                {
+                    remaining.notify_all();
+                }
+            });
+        }
+        for (auto value = remaining.load(); value != 0; value = remaining.load())
+        {
+            remaining.wait(value);
+        }
+    });
+
+    // Latency from submit to the start of the work, for bursts of work like a window handler starts. The time per
+    // item is the percentile of the latencies of 10 bursts of 100.
+    for (const auto percentile : {50u, 99u})
+    {
+        runner.add_timed("work_stealing_pool/submit_to_start_p" + std::to_string(percentile), 1, [&pool, percentile] {
+            constexpr size_t bursts = 10, burst = 100;
+            std::vector<clock_type::duration> latencies(bursts * burst);
+            for (size_t b = 0; b < bursts; b++)
+            {
+                std::atomic<size_t> remaining{burst};
+                for (size_t i = 0; i < burst; i++)
+                {
+                    pool.submit([&latencies, &remaining, slot = b * burst + i, submitted = clock_type::now()] {
+                        latencies[slot] = clock_type::now() - submitted;
+                        if (remaining.fetch_sub(1) == 1)
+                        {
+                            remaining.notify_all();
+                        }
+                    });
+                }
+                for (auto value = remaining.load(); value != 0; value = remaining.load())
+                {
+                    remaining.wait(value);
+                }
+            }
+            const auto rank = latencies.begin() + static_cast<std::ptrdiff_t>((latencies.size() - 1) * percentile / 100);
+            std::nth_element(latencies.begin(), rank, latencies.end());
+            return *rank;
+        });
+    }
+
+    runner.add("startup_trace/record", 100000, [] {
+        auto& log = win32app::trace_log::instance();
+        for (int i = 0; i < 100000; i++)
+        {
+            log.record("benchmark", i, 1);
+        }
+    });
+}
+
+// A UI thread for the placement benchmarks, runs the work posted to it in order.
+struct simulated_ui_thread
+{
+    simulated_ui_thread() : m_thread([this](std::stop_token stop) { run(stop); })
+    {
+    }
+
+    void post(std::function<void()> work)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_queue.push_back(std::move(work));
+        }
+        m_cv.notify_one();
+    }
+
+private:
+    void run(std::stop_token stop)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        while (m_cv.wait(lock, stop, [&] { return !m_queue.empty(); }))
+        {
+            auto work = std::move(m_queue.front());
+            m_queue.pop_front();
+            lock.unlock();
+            work();
+            work = nullptr; // records the handler time before the next item starts
+            lock.lock();
+        }
+    }
+
+    std::mutex m_lock;
+    std::condition_variable_any m_cv;
+    std::deque<std::function<void()>> m_queue;
+    std::jthread m_thread; // last, stopped and joined first
+};
+
+void spin_for(std::chrono::nanoseconds duration)
+{
+    const auto end = clock_type::now() + duration;
+    while (clock_type::now() < end)
+    {
+    }
+}
+
+// Opens windows one at a time on 4 simulated UI threads, each window open posts itemsPerStep work items as the next
+// one opens. One window in 8 is expensive (20us per item) and the others cheap (1us). Measures the time until all
+// the work is done, with least_loaded the expensive windows should spread across the threads.
+constexpr size_t simulated_work_items(size_t windowCount, size_t itemsPerStep)
+{
+    return itemsPerStep * windowCount * (windowCount + 1) / 2;
+}
+
+void simulate_placement(win32app::placement_policy policy, size_t windowCount, size_t itemsPerStep)
+{
+    win32app::ui_thread_placement placement(4, policy);
+    std::vector<win32app::ui_thread_placement::window_slot> slots;
+    slots.reserve(windowCount);
+    std::atomic<size_t> remaining{simulated_work_items(windowCount, itemsPerStep)};
+    std::array<simulated_ui_thread, 4> threads; // joined before the placement and the slots are destroyed
+    for (size_t window = 0; window < windowCount; window++)
+    {
+        slots.push_back(placement.place());
+        for (size_t i = 0; i <= window; i++)
+        {
+            const auto& slot = slots[i];
+            for (size_t item = 0; item < itemsPerStep; item++)
+            {
+                const auto cost = std::chrono::nanoseconds((i % 8 == 0) ? 20000 : 1000);
+                threads[slot.thread()].post([work = std::make_shared<win32app::ui_thread_placement::work_item>(slot.queue_work()), cost, &remaining] {
+                    work->start();
+                    spin_for(cost);
+                    if (remaining.fetch_sub(1) == 1)
+                    {
+                        remaining.notify_all();
+                    }
+                });
+            }
+        }
+    }
+    for (auto value = remaining.load(); value != 0; value = remaining.load())
+    {
+        remaining.wait(value);
+    }
+}
+
+void add_placement_benchmarks(benchmark_runner& runner)
+{
+    win32app::ui_thread_placement placement(8);
+    constexpr size_t windows = 10000;
+    runner.add("ui_thread_placement/place_release_10k", windows, [&] {
+        for (size_t i = 0; i < windows; i++)
+        {
+            auto slot = placement.place((i % 4 == 0) ? std::optional<uint32_t>(static_cast<uint32_t>(i % 64)) : std::nullopt);
+            keep(slot.thread());
+        }
+    });
+
+    const auto slot = placement.place();
+    runner.add("ui_thread_placement/queue_work_10k", windows, [&] {
+        for (size_t i = 0; i < windows; i++)
+        {
+            auto work = slot.queue_work();
+            work.start();
+        }
+    });
+
+    constexpr size_t simulatedWindows = 64;
+    constexpr size_t itemsPerStep = 2;
+    runner.add("ui_thread_placement/simulated_64_windows_least_loaded", simulated_work_items(simulatedWindows, itemsPerStep),
+        [] { simulate_placement(win32app::placement_policy::least_loaded, simulatedWindows, itemsPerStep); });
+    runner.add("ui_thread_placement/simulated_64_windows_round_robin", simulated_work_items(simulatedWindows, itemsPerStep),
+        [] { simulate_placement(win32app::placement_policy::round_robin, simulatedWindows, itemsPerStep); });
+}
+
+void add_layout_benchmarks(benchmark_runner& runner)
+{
+    const win32app::layout_rect client{0, 0, 800, 600};
+    int32_t width = 800;
+
+    // From a small dialog to a generated form, the cost per control should not grow with the count.
+    // far_edges_per_control is the RECT array form of OnSize, one control at a time from its offsets.
+    for (const size_t controls : {10u, 100u, 1000u, 10000u})
+    {
+        win32app::anchor_layout layout;
+        std::vector<uint8_t> edges;
+        std::vector<win32app::layout_rect> offsets;
+        std::vector<win32app::layout_rect> rects;
+        std::mt19937 rng(4);
+        for (size_t i = 0; i < controls; i++)
+        {
+            const auto left = static_cast<int32_t>(rng() % 700), top = static_cast<int32_t>(rng() % 500);
+            const win32app::layout_rect rect{left, top, left + 80, top + 24};
+            const auto anchors = static_cast<uint8_t>(rng() % 16);
+            layout.add(anchors, rect, client);
+            edges.push_back(anchors);
+            offsets.push_back(win32app::anchor_offsets(anchors, rect, client));
+            rects.push_back(rect);
+        }
+
+        const auto suffix = "_" + std::to_string(controls) + "_controls";
+        runner.add("anchor_layout/compute" + suffix, controls, [&] {
+            width = (width == 1600) ? 800 : width + 1;
+            layout.compute({0, 0, width, 600}, rects);
+            keep(rects[0]);
+        });
+        runner.add("anchor_layout/update" + suffix, controls, [&] {
+            width = (width == 1600) ? 800 : width + 1;
+            keep(layout.update({0, 0, width, 600}).size());
+        });
+        runner.add("anchor_layout/far_edges_per_control" + suffix, controls, [&] {
+            width = (width == 1600) ? 800 : width + 1;
+            const win32app::layout_rect resized{0, 0, width, 600};
+            for (size_t i = 0; i < rects.size(); i++)
+            {
+                rects[i] = win32app::anchor_far_edges(edges[i], offsets[i], resized, rects[i]);
+            }
+            keep(rects[0]);
+        });
+    }
+
+    static constexpr auto c_grid = win32app::grid_constraints<8, 8>();
+    win32app::constraint_table<64> table{c_grid};
+    std::array<win32app::layout_rect, 64> initial{};
+    for (size_t i = 0; i < initial.size(); i++)
+    {
+        const auto column = static_cast<int32_t>(i % 8), row = static_cast<int32_t>(i / 8);
+        initial[i] = {column * 100 + 4, row * 75 + 4, column * 100 + 96, row * 75 + 71};
+    }
+    table.record(initial, client);
+    runner.add("constraint_table/compute_64_controls", 64, [&] {
+        width = (width == 1600) ? 800 : width + 1;
+        keep(table.compute({0, 0, width, 600}, 144));
+    });
+
+    runner.add("resize_throttle/drag_1000_events", 1000, [] {
+        win32app::resize_throttle throttle;
+        auto now = clock_type::time_point{} + std::chrono::seconds(1);
+        throttle.enter_size_move();
+        size_t layouts = 0;
+        for (int i = 0; i < 1000; i++)
+        {
+            now += std::chrono::milliseconds(2); // a 500Hz mouse
+            layouts += throttle.size_changed(now).layout ? 1 : 0;
+        }
+        throttle.exit_size_move();
+        keep(layouts);
+    });
+}
+
+win32app::window_snapshot make_snapshot(size_t count, uint64_t firstHandle, uint32_t seed)
+{
+    win32app::window_snapshot snapshot;
+    snapshot.reserve(count);
+    std::mt19937 rng(seed);
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint32_t style = ((rng() % 3) ? win32app::window_style::visible : 0) | ((rng() % 10) ? 0 : win32app::window_style::minimized);
+        const uint32_t exStyle = (rng() % 5) ? 0 : win32app::window_style::ex_tool_window;
+        const auto left = static_cast<int32_t>(rng() % 1000);
+        snapshot.add((firstHandle + i) * 4, style, exStyle, {left, 0, left + static_cast<int32_t>(rng() % 2) * 300, 200}, (rng() % 4) ? 0 : 8,
+            (rng() % 2) ? std::wstring_view(L"Document - Editor") : std::wstring_view(L"Settings"));
+    }
+    return snapshot;
+}
+
+void add_window_benchmarks(benchmark_runner& runner)
+{
+    constexpr size_t count = 20000;
+    const auto before = make_snapshot(count, 1, 5);
+    const auto after = make_snapshot(count, 101, 6);
+    runner.add("window_snapshot/capture_20k_synthetic", count, [&] { keep(make_snapshot(count, 1, 5).size()); });
+    runner.add("window_snapshot/app_like_windows_20k", count, [&] { keep(win32app::app_like_windows(before).size()); });
+    runner.add("window_snapshot/diff_20k", count, [&] { keep(win32app::diff(before, after).changed.size()); });
+
+    // A drag reports a location change per mouse move, the queue coalesces them per window.
+    constexpr size_t events = 100000;
+    std::vector<win32app::pending_window_events> stream;
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < events; i++)
+    {
+        stream.push_back({(rng() % 500 + 1) * 4, static_cast<uint8_t>((rng() % 8) ? win32app::window_location_changed : win32app::window_name_changed)});
+    }
+    runner.add("window_index/post_apply_100k_events", events, [&] {
+        win32app::window_event_queue queue;
+        win32app::window_index index;
+        for (size_t i = 0; i < stream.size(); i++)
+        {
+            queue.post(stream[i].handle, stream[i].events);
+            if ((i % 1000) == 999) // the batch timer expires
+            {
+                index.apply(queue.take(), [](uint64_t handle, uint8_t, win32app::window_attributes& attributes) {
+                    attributes.rect.right++;
+                    return (handle % 3) != 0;
+                });
+            }
+        }
+        keep(index.size());
+    });
+
+    constexpr size_t titles = 10000;
+    win32app::string_pool pool;
+    runner.add("string_pool/append_10k_titles", titles, [&] {
+        pool.clear();
+        for (size_t i = 0; i < titles; i++)
+        {
+            pool.append_with(127, [&](wchar_t* buffer, size_t) {
+                static constexpr std::wstring_view c_title{L"Untitled - Notepad"};
+                std::copy(c_title.begin(), c_title.end(), buffer);
+                return c_title.size();
+            });
+        }
+        keep(pool.size());
+    });
+    runner.add("string_pool/std_wstring_10k_titles", titles, [&] {
+        std::vector<std::wstring> strings;
+        for (size_t i = 0; i < titles; i++)
+        {
+            strings.emplace_back(L"Untitled - Notepad");
+        }
+        keep(strings.size());
+    });
+
+    win32app::class_name_cache cache;
+    runner.add("class_name_cache/get_10k", titles, [&] {
+        for (size_t i = 0; i < titles; i++)
+        {
+            keep(cache.get(static_cast<uint16_t>(0xC000 + i % 40), [] { return std::wstring(L"ApplicationFrameWindow"); }).size());
+        }
+    });
+}
+
+struct DispatchWindow
+{
+#if defined(_WIN32)
+    wil::unique_hwnd m_window;
+#else
+    win32_shim::unique_hwnd m_window;
+#endif
+    size_t m_count{};
+
+    LRESULT Size(unsigned short dx, unsigned short dy)
+    {
+        m_count += dx + dy;
+        return 0;
+    }
+
+    LRESULT Move(unsigned short, unsigned short)
+    {
+        m_count++;
+        return 0;
+    }
+
+    LRESULT Command(unsigned int id)
+    {
+        m_count += id;
+        return 0;
+    }
+};
+
+// Takes the messages that have no handler of their own through HandleMessage, after the built in ones are checked.
+struct CatchAllWindow : DispatchWindow
+{
+    LRESULT HandleMessage(UINT32 message, WPARAM wparam, LPARAM)
+    {
+        m_count += message + wparam;
+        return 0;
+    }
+};
+
+struct stream_message
+{
+    UINT message;
+    WPARAM wparam;
+    LPARAM lparam;
+};
+
+// A stream of messages in random order, so the dispatch can not be folded into the loop.
+std::vector<stream_message> make_message_stream(size_t count, std::span<const UINT> messages, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<stream_message> stream(count);
+    for (auto& entry : stream)
+    {
+        entry = {messages[rng() % messages.size()], rng() & 0xFFFF, MAKELPARAM(rng() & 0xFFFF, rng() & 0xFFFF)};
+    }
+    return stream;
+}
+
+void add_dispatch_benchmarks(benchmark_runner& runner)
+{
+    constexpr size_t count = 300000;
+    constexpr UINT c_appMessage = 0x8000; // WM_APP
+    static constexpr UINT c_handled[]{WM_SIZE, WM_MOVE, WM_COMMAND};
+    static constexpr UINT c_mixed[]{WM_SIZE, WM_MOVE, WM_COMMAND, c_appMessage};
+
+    DispatchWindow window;
+    const auto handled = make_message_stream(count, c_handled, 9);
+    runner.add("dispatch/handle_message_300k", count, [&] {
+        for (const auto& entry : handled)
+        {
+            win32app::details::HandleMessage(&window, entry.message, entry.wparam, entry.lparam);
+        }
+        keep(window.m_count);
+    });
+
+    // A quarter of the messages go to the catch all HandleMessage.
+    CatchAllWindow catchAll;
+    const auto mixed = make_message_stream(count, c_mixed, 10);
+    runner.add("dispatch/handle_message_catch_all_300k", count, [&] {
+        for (const auto& entry : mixed)
+        {
+            win32app::details::HandleMessage(&catchAll, entry.message, entry.wparam, entry.lparam);
+        }
+        keep(catchAll.m_count);
+    });
+}
+
+#if defined(_WIN32)
+
+enum class BenchmarkGroupId
+{
+    Default,
+};
+
+struct BenchmarkGroupInfo
+{
+    BenchmarkGroupId Id;
+    PCWSTR Name;
+};
+
+void add_windows_benchmarks(benchmark_runner& runner)
+{
+    const auto mixed = make_text(1024 * 1024, false, 8);
+    runner.add("utf8/from_utf8_1MB", mixed.size(), [&] { keep(from_utf8(mixed).size()); });
+
+    INITCOMMONCONTROLSEX icc{sizeof(icc), ICC_LISTVIEW_CLASSES};
+    InitCommonControlsEx(&icc);
+    wil::unique_hwnd list(CreateWindowExW(0, WC_LISTVIEWW, L"", WS_POPUP | LVS_REPORT, 0, 0, 400, 400, nullptr, nullptr, nullptr, nullptr));
+    static const BenchmarkGroupInfo c_groups[]{{BenchmarkGroupId::Default, L"Benchmark"}};
+    LogWindow<BenchmarkGroupInfo, BenchmarkGroupId> log(c_groups, ARRAYSIZE(c_groups));
+    log.InitListView(list.get());
+    constexpr size_t entries = 1000;
+    runner.add("log_window/log_1000_entries_and_export", entries, [&] {
+        log.ResetContents();
+        log.LogGroup(BenchmarkGroupId::Default, L"Benchmark");
+        for (size_t i = 0; i < entries; i++)
+        {
+            log.LogMessagePrintf(BenchmarkGroupId::Default, L"entry", L"%zu", i);
+        }
+        GlobalFree(log.GetText(false));
+    });
+}
+
+#if defined(WIN32APP_BENCHMARK_XAML)
+// Prewarm and Xaml initialization happen once per process, each run of the time to first window benchmark is a new
+// process started with --first-window. The child times its main() to its first XamlHostWindow being shown, with
+// 20ms of other start up work on the main thread for Prewarm to overlap, and exits with that time in microseconds.
+constexpr wchar_t c_firstWindowMarkup[] = LR"(<Grid xmlns="http://schemas.microsoft.com/winfx/2006/xaml/presentation"
+    xmlns:x="http://schemas.microsoft.com/winfx/2006/xaml"><TextBlock x:Name="Status"/></Grid>)";
+const win32app::embedded_resource c_firstWindowIndex[]{{L"AppWindow.xaml", 0, static_cast<uint32_t>(ARRAYSIZE(c_firstWindowMarkup) - 1)}};
+const win32app::embedded_resource_table c_firstWindowResources{c_firstWindowIndex, ARRAYSIZE(c_firstWindowIndex), c_firstWindowMarkup};
+
+int run_first_window(clock_type::time_point processStart, bool prewarm)
+{
+    auto coInit = wil::CoInitializeEx(COINIT_APARTMENTTHREADED);
+    XamlHostWindow::UseEmbeddedResources(c_firstWindowResources);
+    if (prewarm)
+    {
+        XamlHostWindow::Prewarm();
+    }
+    spin_for(std::chrono::milliseconds(20)); // the rest of the app's start up
+
+    wil::unique_event shown{wil::EventOptions::None};
+    std::shared_ptr<XamlHostWindow> window;
+    XamlHostWindow::StartThreadAsync([&](auto&& queueController) {
+        window = std::make_shared<XamlHostWindow>(std::move(queueController));
+        window->Show(SW_SHOWNOACTIVATE);
+        shown.SetEvent();
+    });
+    shown.wait();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - processStart);
+
+    window->RunAsync([](auto& hostWindow) noexcept { hostWindow.m_window.reset(); }).get();
+    XamlHostWindow::ShutdownPrewarmed();
+    XamlHostWindow::wait_until_zero();
+    return static_cast<int>(elapsed.count());
+}
+
+clock_type::duration time_first_window_process(const wchar_t* mode)
+{
+    wchar_t path[MAX_PATH]{};
+    THROW_LAST_ERROR_IF(GetModuleFileNameW(nullptr, path, ARRAYSIZE(path)) == 0);
+    auto commandLine = L"\"" + std::wstring(path) + L"\" --first-window " + mode;
+    STARTUPINFOW startup{sizeof(startup)};
+    wil::unique_process_information process;
+    THROW_IF_WIN32_BOOL_FALSE(CreateProcessW(path, commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process));
+    WaitForSingleObject(process.hProcess, INFINITE);
+    DWORD exitCode{};
+    THROW_IF_WIN32_BOOL_FALSE(GetExitCodeProcess(process.hProcess, &exitCode));
+    return std::chrono::microseconds(exitCode);
+}
+
+void add_xaml_benchmarks(benchmark_runner& runner)
+{
+    runner.add_timed("xaml/time_to_first_window", 1, [] { return time_first_window_process(L"cold"); });
+    runner.add_timed("xaml/time_to_first_window_prewarm", 1, [] { return time_first_window_process(L"prewarm"); });
+}
+#endif
+#endif
+} // namespace
+
+int main(int argc, char* argv[])
+{
+#if defined(_WIN32) && defined(WIN32APP_BENCHMARK_XAML)
+    const auto processStart = clock_type::now();
+    if ((argc == 3) && (std::string_view(argv[1]) == "--first-window"))
+    {
+        return run_first_window(processStart, std::string_view(argv[2]) == "prewarm");
+    }
+#endif
+
+    benchmark_options options;
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+        if ((arg == "--filter") && (i + 1 < argc))
+        {
+            options.filter = argv[++i];
+        }
+        else if ((arg == "--min-time") && (i + 1 < argc))
+        {
+            options.minTime = std::chrono::milliseconds(std::atoi(argv[++i]));
+        }
+        else if ((arg == "--json") && (i + 1 < argc))
+        {
+            jsonPath = argv[++i];
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: benchmarks [--filter text] [--min-time milliseconds] [--json path]\n");
+            return 2;
+        }
+    }
+
+    benchmark_runner runner(options);
+    add_utf8_benchmarks(runner);
+    add_threading_benchmarks(runner);
+    add_placement_benchmarks(runner);
+    add_layout_benchmarks(runner);
+    add_window_benchmarks(runner);
+    add_dispatch_benchmarks(runner);
+#if defined(_WIN32)
+    add_windows_benchmarks(runner);
+#if defined(WIN32APP_BENCHMARK_XAML)
+    add_xaml_benchmarks(runner);
+#endif
+#endif
+
+    if (jsonPath)
+    {
+        std::ofstream file(jsonPath, std::ios::trunc);
+        runner.write_json(file);
+        if (!file)
+        {
+            std::fprintf(stderr, "benchmarks: unable to write %s\n", jsonPath);
+            return 1;
+        }
+    }
+    else
+    {
+        runner.write_json(std::cout);
+    }
+    return 0;
+}
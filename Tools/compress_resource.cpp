@@ -0,0 +1,59 @@
+// compress_resource
+//
+// Build time tool that writes a resource file in the compressed resource format described in
+// win32app/compressed_resource.h. Reference the output from the .rc file in place of the original,
+// get_decompressed_resource_view() and get_decoded_resource_view() decompress it on first use.
+//
+//    compress_resource AppWindow.xaml AppWindow.xaml.lz4
+//
+//    AppWindow.xaml RCDATA "AppWindow.xaml.lz4"
+//
+// This is portable C++20, build it with the compiler for the build machine, for example
+//    cl /std:c++20 /EHsc /I..\inc compress_resource.cpp
+//    g++ -std=c++20 -I../inc compress_resource.cpp -o compress_resource
+
+#include <win32app/compressed_resource.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::fprintf(stderr, "usage: compress_resource input output\n");
+        return 2;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input)
+    {
+        std::fprintf(stderr, "compress_resource: unable to open %s\n", argv[1]);
+        return 1;
+    }
+    const std::string content{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+
+    const auto compressed = win32app::make_compressed_resource(content);
+
+    // Verify the round trip, a corrupt resource would only be found at runtime.
+    const auto header = win32app::parse_compressed_resource_header(compressed);
+    const auto decompressed = header ? win32app::decompress_resource(*header) : std::nullopt;
+    if (!decompressed || (*decompressed != content))
+    {
+        std::fprintf(stderr, "compress_resource: round trip failed for %s\n", argv[1]);
+        return 1;
+    }
+
+    std::ofstream output(argv[2], std::ios::binary | std::ios::trunc);
+    output << compressed;
+    if (!output)
+    {
+        std::fprintf(stderr, "compress_resource: unable to write %s\n", argv[2]);
+        return 1;
+    }
+
+    std::printf("%s: %zu -> %zu bytes\n", argv[1], content.size(), compressed.size());
+    return 0;
+}
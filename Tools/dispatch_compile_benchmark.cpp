@@ -0,0 +1,347 @@
+// dispatch_compile_benchmark
+//
+// Measures the compile time of the message dispatch for many window classes. Generates two translation
+// units with the same window classes, each with a different subset of the message handlers, one using
+// win32app/message_dispatch.h (concepts and message_traits) and one using the is_detected based dispatch
+// it replaced, then compiles each a few times with the given command and reports the time per class as
+// JSON, in the format of benchmarks.cpp.
+//
+//    dispatch_compile_benchmark --compile "g++ -std=c++20 -O2 -I../inc -I."
+//    dispatch_compile_benchmark --classes 1000 --out build --compile "clang++ -std=c++20 -O2 -I../inc -I."
+//    dispatch_compile_benchmark --out build      only writes the translation units
+//
+// The translation units include win32_shim.h (this directory) for the Win32 types, so they build on any
+// platform. The command must find it and the inc directory, it is run as: command -c file -o file.o
+//
+// This is portable C++20, build it with the compiler for the build machine, for example
+//    cl /std:c++20 /EHsc dispatch_compile_benchmark.cpp
+//    g++ -std=c++20 dispatch_compile_benchmark.cpp -o dispatch_compile_benchmark
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+// The dispatch before message_traits, as it was in win32_app_helpers.h. Changed only where GCC and Clang
+// reject it: the alias templates no longer shadow T and the catch all uses ~0u in place of -1.
+constexpr std::string_view c_isDetectedDispatch = R"(#include <win32app/is_detected.h>
+
+namespace legacy
+{
+    template <unsigned int value_, typename T>
+    struct msg
+    {
+        static constexpr unsigned int value = value_;
+        static constexpr bool is_valid = false;
+    };
+
+    template <typename T>
+    struct msg<WM_SIZE, T>
+    {
+        template <typename U>
+        using resultT = decltype(std::declval<U>().Size(std::declval<unsigned short>(), std::declval<unsigned short>()));
+        static constexpr bool is_valid = is_detected<resultT, T>::value;
+    };
+
+    template <typename T>
+    struct msg<WM_MOVE, T>
+    {
+        template <typename U>
+        using resultT = decltype(std::declval<U>().Move(std::declval<unsigned short>(), std::declval<unsigned short>()));
+        static constexpr bool is_valid = is_detected<resultT, T>::value;
+    };
+
+    template <typename T>
+    struct msg<WM_CREATE, T>
+    {
+        template <typename U>
+        using resultT = decltype(std::declval<U>().Create());
+        static constexpr bool is_valid = is_detected<resultT, T>::value;
+    };
+
+    template <typename T>
+    struct msg<WM_DESTROY, T>
+    {
+        template <typename U>
+        using resultT = decltype(std::declval<U>().Destroy());
+        static constexpr bool is_valid = is_detected<resultT, T>::value;
+    };
+
+    template <typename T>
+    struct msg<WM_PAINT, T>
+    {
+        template <typename U>
+        using resultT = decltype(std::declval<U>().Paint(std::declval<HDC>(), std::declval<const PAINTSTRUCT&>()));
+        static constexpr bool is_valid = is_detected<resultT, T>::value;
+    };
+
+    template <typename T>
+    struct msg<WM_COMMAND, T>
+    {
+        template <typename U>
+        using resultT = decltype(std::declval<U>().Command(std::declval<unsigned short>()));
+        static constexpr bool is_valid = is_detected<resultT, T>::value;
+    };
+
+    template <typename T>
+    struct msg<WM_DEVICECHANGE, T>
+    {
+        template <typename U>
+        using resultT = decltype(std::declval<U>().DeviceChange(std::declval<unsigned int>(), std::declval<void*>()));
+        static constexpr bool is_valid = is_detected<resultT, T>::value;
+    };
+
+    template <typename T>
+    struct msg<~0u, T>
+    {
+        template <typename U>
+        using resultT = decltype(std::declval<U>().HandleMessage(std::declval<UINT32>(), std::declval<WPARAM>(), std::declval<LPARAM>()));
+        static constexpr bool is_valid = is_detected<resultT, T>::value;
+    };
+
+    template <typename T>
+    auto HandleMessage(T* that, UINT32 message, WPARAM wparam, LPARAM lparam)
+    {
+        switch (message)
+        {
+        case WM_MOVE:
+            if constexpr (msg<WM_MOVE, T>::is_valid)
+            {
+                const WORD dx = LOWORD(lparam), dy = HIWORD(lparam);
+                return that->Move(dx, dy);
+            }
+            break;
+
+        case WM_SIZE:
+            if constexpr (msg<WM_SIZE, T>::is_valid)
+            {
+                const WORD dx = LOWORD(lparam), dy = HIWORD(lparam);
+                return that->Size(dx, dy);
+            }
+            break;
+
+        case WM_CREATE:
+            if constexpr (msg<WM_CREATE, T>::is_valid)
+            {
+                return that->Create();
+            }
+            break;
+
+        case WM_DESTROY:
+            if constexpr (msg<WM_DESTROY, T>::is_valid)
+            {
+                return that->Destroy();
+            }
+            break;
+
+        case WM_PAINT:
+            if constexpr (msg<WM_PAINT, T>::is_valid)
+            {
+                PAINTSTRUCT ps{};
+                auto hdc{BeginPaint(that->m_window.get(), &ps)};
+                auto result = that->Paint(hdc, ps);
+                EndPaint(that->m_window.get(), &ps);
+                return result;
+            }
+            break;
+
+        case WM_COMMAND:
+            if constexpr (msg<WM_COMMAND, T>::is_valid)
+            {
+                return that->Command(LOWORD(wparam));
+            }
+            break;
+
+        case WM_DEVICECHANGE:
+            if constexpr (msg<WM_DEVICECHANGE, T>::is_valid)
+            {
+                return that->DeviceChange(static_cast<UINT>(wparam), reinterpret_cast<void*>(lparam));
+            }
+            break;
+
+        default:
+        {
+            if constexpr (msg<~0u, T>::is_valid)
+            {
+                return that->HandleMessage(message, wparam, lparam);
+            }
+        }
+        break;
+        }
+        return DefWindowProcW(that->m_window.get(), message, wparam, lparam);
+    }
+} // namespace legacy
+
+#define DISPATCH legacy::HandleMessage
+)";
+
+constexpr std::string_view c_conceptsDispatch = R"(#include <win32app/message_dispatch.h>
+
+#define DISPATCH win32app::details::HandleMessage
+)";
+
+// The handlers a class can have, each class has the ones selected by the bits of a hash of its index.
+constexpr std::string_view c_handlers[]{
+    "    LRESULT Size(unsigned short dx, unsigned short dy) { return dx + dy + %; }\n",
+    "    LRESULT Move(unsigned short, unsigned short) { return %; }\n",
+    "    LRESULT Create() { return %; }\n",
+    "    LRESULT Destroy() { return %; }\n",
+    "    LRESULT Paint(HDC, const PAINTSTRUCT&) { return %; }\n",
+    "    LRESULT Command(unsigned short id) { return id + %; }\n",
+    "    LRESULT DeviceChange(unsigned int, void*) { return %; }\n",
+    "    LRESULT HandleMessage(UINT32 message, WPARAM, LPARAM) { return message + %; }\n",
+};
+
+std::string replace_all(std::string_view text, std::string_view from, std::string_view to)
+{
+    std::string result;
+    for (size_t position = 0;;)
+    {
+        const auto found = text.find(from, position);
+        result.append(text.substr(position, found - position));
+        if (found == std::string_view::npos)
+        {
+            return result;
+        }
+        result.append(to);
+        position = found + from.size();
+    }
+}
+
+std::string make_translation_unit(std::string_view dispatch, size_t classes)
+{
+    std::string result = "// Generated by dispatch_compile_benchmark, do not edit.\n#include \"win32_shim.h\"\n";
+    result += dispatch;
+    for (size_t i = 0; i < classes; i++)
+    {
+        const auto index = std::to_string(i);
+        const auto handlers = static_cast<uint32_t>((i + 1) * 2654435761u) >> 24; // a spread of handler subsets
+        result += "\nstruct Window" + index + "\n{\n    win32_shim::unique_hwnd m_window;\n";
+        for (size_t handler = 0; handler < std::size(c_handlers); handler++)
+        {
+            if (handlers & (1u << handler))
+            {
+                result += replace_all(c_handlers[handler], "%", index);
+            }
+        }
+        result += "};\n\nLRESULT Dispatch" + index + "(Window" + index + "& window, UINT32 message, WPARAM wparam, LPARAM lparam)\n{\n" +
+                  "    return DISPATCH(&window, message, wparam, lparam);\n}\n";
+    }
+    return result;
+}
+
+struct compile_result
+{
+    std::string name;
+    size_t classes;
+    std::vector<double> seconds; // sorted
+};
+
+// Returns nothing in seconds if the compile failed.
+compile_result time_compile(const std::string& command, const std::string& path, std::string name, size_t classes, int runs)
+{
+    compile_result result{std::move(name), classes, {}};
+    const auto commandLine = command + " -c \"" + path + "\" -o \"" + path + ".o\"";
+    for (int run = 0; run < runs; run++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if (std::system(commandLine.c_str()) != 0)
+        {
+            std::fprintf(stderr, "dispatch_compile_benchmark: failed: %s\n", commandLine.c_str());
+            result.seconds.clear();
+            return result;
+        }
+        result.seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(result.seconds.begin(), result.seconds.end());
+    return result;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t classes = 500;
+    std::string out = ".";
+    std::string command;
+    int runs = 3;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+        if ((arg == "--classes") && (i + 1 < argc))
+        {
+            classes = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if ((arg == "--out") && (i + 1 < argc))
+        {
+            out = argv[++i];
+        }
+        else if ((arg == "--compile") && (i + 1 < argc))
+        {
+            command = argv[++i];
+        }
+        else if ((arg == "--runs") && (i + 1 < argc))
+        {
+            runs = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: dispatch_compile_benchmark [--classes count] [--out directory] [--compile command] [--runs count]\n");
+            return 2;
+        }
+    }
+
+    const struct
+    {
+        const char* name;
+        std::string_view dispatch;
+    } variants[]{{"concepts", c_conceptsDispatch}, {"is_detected", c_isDetectedDispatch}};
+
+    std::vector<compile_result> results;
+    for (const auto& variant : variants)
+    {
+        const auto path = out + "/dispatch_" + variant.name + ".cpp";
+        std::ofstream file(path, std::ios::trunc);
+        file << make_translation_unit(variant.dispatch, classes);
+        if (!file)
+        {
+            std::fprintf(stderr, "dispatch_compile_benchmark: unable to write %s\n", path.c_str());
+            return 1;
+        }
+        file.close();
+
+        if (!command.empty())
+        {
+            auto result = time_compile(command, path, "compile/dispatch_" + std::string(variant.name) + "_" + std::to_string(classes) + "_classes", classes, runs);
+            if (result.seconds.empty())
+            {
+                return 1;
+            }
+            std::fprintf(stderr, "%-48s %12.3f s median %12.3f best %8zu runs\n", result.name.c_str(), result.seconds[result.seconds.size() / 2],
+                result.seconds.front(), result.seconds.size());
+            results.push_back(std::move(result));
+        }
+    }
+
+    if (!results.empty())
+    {
+        std::cout << "{\"schema\":1,\"benchmarks\":[";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const auto& result = results[i];
+            const auto perClass = [&](double seconds) { return seconds * 1e9 / static_cast<double>(result.classes); };
+            std::cout << (i ? ",\n" : "\n") << "{\"name\":\"" << result.name << "\",\"items\":" << result.classes << ",\"runs\":" << result.seconds.size()
+                      << ",\"median_ns_per_item\":" << perClass(result.seconds[result.seconds.size() / 2])
+                      << ",\"best_ns_per_item\":" << perClass(result.seconds.front()) << "}";
+        }
+        std::cout << "\n]}\n";
+    }
+    return 0;
+}
@@ -0,0 +1,293 @@
+// embed_utf16_resources
+//
+// Build time generator that converts UTF-8 text files (XAML, JSON, ...) into a C++ header containing
+// their UTF-16 form, packed into a single constexpr array with a sorted index. Use it with
+// win32app/embedded_resources.h to avoid converting these resources from UTF-8 every time the
+// app starts.
+//
+//    embed_utf16_resources --namespace app_resources -o AppResources.g.h AppWindow.xaml Strings=strings.json
+//
+// Each input is either a path, named by its file name, or name=path. A leading UTF-8 BOM is skipped.
+//
+// This is portable C++20, build it with the compiler for the build machine, for example
+//    cl /std:c++20 /EHsc /I..\inc embed_utf16_resources.cpp
+//    g++ -std=c++20 -I../inc embed_utf16_resources.cpp -o embed_utf16_resources
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+struct input_resource
+{
+    std::string name;
+    std::u16string content;
+};
+
+std::string read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("unable to open " + path);
+    }
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+// Strict conversion, rejects overlong forms, surrogates and values past U+10FFFF like MB_ERR_INVALID_CHARS.
+std::u16string utf8_to_utf16(std::string_view text, const std::string& name)
+{
+    std::u16string result;
+    result.reserve(text.size());
+
+    const auto bytes = reinterpret_cast<const unsigned char*>(text.data());
+    size_t i = 0;
+    while (i < text.size())
+    {
+        const unsigned char lead = bytes[i];
+        char32_t codePoint{};
+        size_t length{};
+        char32_t minimum{};
+        if (lead < 0x80)
+        {
+            codePoint = lead;
+            length = 1;
+        }
+        else if ((lead & 0xE0) == 0xC0)
+        {
+            codePoint = lead & 0x1F;
+            length = 2;
+            minimum = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            codePoint = lead & 0x0F;
+            length = 3;
+            minimum = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            codePoint = lead & 0x07;
+            length = 4;
+            minimum = 0x10000;
+        }
+        else
+        {
+            throw std::runtime_error(name + ": invalid UTF-8 at offset " + std::to_string(i));
+        }
+
+        if (i + length > text.size())
+        {
+            throw std::runtime_error(name + ": truncated UTF-8 at offset " + std::to_string(i));
+        }
+        for (size_t j = 1; j < length; j++)
+        {
+            if ((bytes[i + j] & 0xC0) != 0x80)
+            {
+                throw std::runtime_error(name + ": invalid UTF-8 at offset " + std::to_string(i));
+            }
+            codePoint = (codePoint << 6) | (bytes[i + j] & 0x3F);
+        }
+        if ((codePoint < minimum) || (codePoint > 0x10FFFF) || ((codePoint >= 0xD800) && (codePoint <= 0xDFFF)))
+        {
+            throw std::runtime_error(name + ": invalid UTF-8 at offset " + std::to_string(i));
+        }
+
+        if (codePoint >= 0x10000)
+        {
+            codePoint -= 0x10000;
+            result.push_back(static_cast<char16_t>(0xD800 + (codePoint >> 10)));
+            result.push_back(static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF)));
+        }
+        else
+        {
+            result.push_back(static_cast<char16_t>(codePoint));
+        }
+        i += length;
+    }
+    return result;
+}
+
+input_resource load_input(const std::string& argument)
+{
+    std::string name, path;
+    if (auto equals = argument.find('='); equals != std::string::npos)
+    {
+        name = argument.substr(0, equals);
+        path = argument.substr(equals + 1);
+    }
+    else
+    {
+        path = argument;
+        auto slash = path.find_last_of("/\\");
+        name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    }
+
+    const auto text = read_file(path);
+    std::string_view view{text};
+    if ((view.size() >= 3) && (view.substr(0, 3) == "\xEF\xBB\xBF"))
+    {
+        view.remove_prefix(3); // skip the BOM, like skip_utf8_bom()
+    }
+    return {name, utf8_to_utf16(view, path)};
+}
+
+// The name as the content of a L"" literal. Only printable ASCII is written as is, other characters are
+// written as escapes so the generated header does not depend on the source character set of the compiler.
+std::string escape_name(const std::string& name)
+{
+    const auto utf16 = utf8_to_utf16(name, name);
+    std::string result;
+    char buffer[16];
+    for (size_t i = 0; i < utf16.size(); i++)
+    {
+        const char32_t ch = utf16[i];
+        if ((ch == u'\\') || (ch == u'"'))
+        {
+            result.push_back('\\');
+            result.push_back(static_cast<char>(ch));
+        }
+        else if ((ch >= 0x20) && (ch < 0x7F))
+        {
+            result.push_back(static_cast<char>(ch));
+        }
+        else if (ch < 0xA0)
+        {
+            std::snprintf(buffer, sizeof(buffer), "\\%03o", static_cast<unsigned>(ch)); // octal escapes stop after 3 digits
+            result += buffer;
+        }
+        else if ((ch >= 0xD800) && (ch <= 0xDBFF) && (i + 1 < utf16.size()))
+        {
+            const char32_t codePoint = 0x10000 + ((ch - 0xD800) << 10) + (utf16[++i] - 0xDC00);
+            std::snprintf(buffer, sizeof(buffer), "\\U%08X", static_cast<unsigned>(codePoint));
+            result += buffer;
+        }
+        else
+        {
+            std::snprintf(buffer, sizeof(buffer), "\\u%04X", static_cast<unsigned>(ch));
+            result += buffer;
+        }
+    }
+    return result;
+}
+
+std::string generate_header(std::vector<input_resource> resources, const std::string& namespaceName)
+{
+    // The index is sorted (by UTF-16 code unit, matching std::wstring_view comparison on Windows) to enable binary search.
+    std::sort(resources.begin(), resources.end(), [](const input_resource& left, const input_resource& right) {
+        return utf8_to_utf16(left.name, left.name) < utf8_to_utf16(right.name, right.name);
+    });
+    for (size_t i = 1; i < resources.size(); i++)
+    {
+        if (resources[i - 1].name == resources[i].name)
+        {
+            throw std::runtime_error("duplicate resource name " + resources[i].name);
+        }
+    }
+
+    std::ostringstream out;
+    out << "// Generated by embed_utf16_resources, do not edit.\n"
+        << "#pragma once\n"
+        << "#include <win32app/embedded_resources.h>\n\n"
+        << "namespace " << namespaceName << "\n{\n"
+        << "inline constexpr wchar_t c_data[] =\n{";
+
+    std::vector<uint32_t> offsets;
+    uint32_t offset = 0;
+    size_t column = 0;
+    auto emit = [&](char16_t value) {
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), "%s0x%04X,", (column++ % 12) == 0 ? "\n    " : " ", static_cast<unsigned>(value));
+        out << buffer;
+    };
+    for (const auto& resource : resources)
+    {
+        offsets.push_back(offset);
+        for (auto ch : resource.content)
+        {
+            emit(ch);
+        }
+        emit(0); // null terminate each resource
+        offset += static_cast<uint32_t>(resource.content.size() + 1);
+    }
+    if (resources.empty())
+    {
+        emit(0);
+    }
+    out << "\n};\n\n"
+        << "inline constexpr win32app::embedded_resource c_index[] =\n{\n";
+    for (size_t i = 0; i < resources.size(); i++)
+    {
+        out << "    {L\"" << escape_name(resources[i].name) << "\", " << offsets[i] << ", " << resources[i].content.size() << "},\n";
+    }
+    if (resources.empty())
+    {
+        out << "    {L\"\", 0, 0},\n";
+    }
+    out << "};\n\n"
+        << "inline constexpr win32app::embedded_resource_table c_table{c_index, " << resources.size() << ", c_data};\n"
+        << "} // namespace " << namespaceName << "\n";
+    return out.str();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        std::string outputPath, namespaceName = "embedded_resources";
+        std::vector<input_resource> resources;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view argument = argv[i];
+            if ((argument == "-o") && (i + 1 < argc))
+            {
+                outputPath = argv[++i];
+            }
+            else if ((argument == "--namespace") && (i + 1 < argc))
+            {
+                namespaceName = argv[++i];
+            }
+            else
+            {
+                resources.push_back(load_input(argv[i]));
+            }
+        }
+
+        if (outputPath.empty())
+        {
+            std::fprintf(stderr, "usage: embed_utf16_resources [--namespace name] -o output.h [name=]input...\n");
+            return 2;
+        }
+
+        auto header = generate_header(std::move(resources), namespaceName);
+
+        // Avoid touching the output when unchanged so dependent files are not rebuilt.
+        std::ifstream existing(outputPath, std::ios::binary);
+        if (existing && (std::string{std::istreambuf_iterator<char>(existing), std::istreambuf_iterator<char>()} == header))
+        {
+            return 0;
+        }
+        existing.close();
+
+        std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+        output << header;
+        if (!output)
+        {
+            throw std::runtime_error("unable to write " + outputPath);
+        }
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "embed_utf16_resources: %s\n", e.what());
+        return 1;
+    }
+}
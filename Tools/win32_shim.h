@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+
+// win32_shim
+//
+// The subset of the Win32 types, messages and functions that win32app/message_dispatch.h uses, so the
+// message dispatch can be built and benchmarked on platforms without the Windows headers. Only for the
+// tools, on Windows include <windows.h> instead. The values match the Windows headers, the functions do
+// nothing.
+//
+//    #include "win32_shim.h"
+//    #include <win32app/message_dispatch.h>
+
+using UINT = unsigned int;
+using UINT32 = uint32_t;
+using WORD = unsigned short;
+using BOOL = int;
+using BYTE = unsigned char;
+using LONG = int32_t;
+using WPARAM = uintptr_t;
+using LPARAM = intptr_t;
+using LRESULT = intptr_t;
+using HWND = struct HWND__*;
+using HDC = struct HDC__*;
+
+struct RECT
+{
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+};
+
+struct PAINTSTRUCT
+{
+    HDC hdc;
+    BOOL fErase;
+    RECT rcPaint;
+    BOOL fRestore;
+    BOOL fIncUpdate;
+    BYTE rgbReserved[32];
+};
+
+constexpr UINT WM_CREATE = 0x0001;
+constexpr UINT WM_DESTROY = 0x0002;
+constexpr UINT WM_MOVE = 0x0003;
+constexpr UINT WM_SIZE = 0x0005;
+constexpr UINT WM_PAINT = 0x000F;
+constexpr UINT WM_COMMAND = 0x0111;
+constexpr UINT WM_DEVICECHANGE = 0x0219;
+constexpr UINT WM_DPICHANGED = 0x02E0;
+
+constexpr WORD LOWORD(uintptr_t value)
+{
+    return static_cast<WORD>(value & 0xFFFF);
+}
+
+constexpr WORD HIWORD(uintptr_t value)
+{
+    return static_cast<WORD>((value >> 16) & 0xFFFF);
+}
+
+constexpr LPARAM MAKELPARAM(uintptr_t low, uintptr_t high)
+{
+    return static_cast<LPARAM>((low & 0xFFFF) | ((high & 0xFFFF) << 16));
+}
+
+inline HDC BeginPaint(HWND, PAINTSTRUCT* paint)
+{
+    *paint = {};
+    return nullptr;
+}
+
+inline BOOL EndPaint(HWND, const PAINTSTRUCT*)
+{
+    return 1;
+}
+
+inline LRESULT DefWindowProcW(HWND, UINT, WPARAM, LPARAM)
+{
+    return 0;
+}
+
+namespace win32_shim
+{
+// Stands in for wil::unique_hwnd, the window member the dispatch uses for WM_PAINT and DefWindowProcW.
+struct unique_hwnd
+{
+    HWND get() const
+    {
+        return m_window;
+    }
+
+    HWND m_window{};
+};
+} // namespace win32_shim
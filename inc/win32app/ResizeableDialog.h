@@ -1,3 +1,8 @@
+#pragma once
+#include "anchor_layout.h"
+#include "constraint_layout.h"
+#include "resize_throttle.h"
+
 // to enable a dialog to be re-sizable do the following after including this header:
 //
 // 1) in your class declare
@@ -58,6 +63,27 @@ inline void GetWindowRectInClient(HWND hwnd, _Out_ RECT* prc)
 EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 inline HINSTANCE GetModuleHINSTANCE() { return reinterpret_cast<HINSTANCE>(&__ImageBase); }
 
+// The refresh interval of the display showing hwnd, layout during a live resize is limited to this.
+inline std::chrono::steady_clock::duration GetDisplayFrameInterval(HWND hwnd)
+{
+    int refreshRate = 0;
+    if (HDC hdc = GetDC(hwnd))
+    {
+        refreshRate = GetDeviceCaps(hdc, VREFRESH);
+        ReleaseDC(hwnd, hdc);
+    }
+    if (refreshRate <= 1) // 0 and 1 mean the hardware default
+    {
+        return win32app::resize_throttle::c_defaultFrameInterval;
+    }
+    return std::chrono::microseconds(1000000 / refreshRate);
+}
+
+inline win32app::layout_rect ToLayoutRect(const RECT& rc)
+{
+    return { rc.left, rc.top, rc.right, rc.bottom };
+}
+
 inline void InitResizeData(HWND hdlg, const ANCHOR rgAnchors[], size_t cAnchors, _Out_ RECT rgAnchorOffsets[])
 {
     // record anchor information
@@ -66,33 +92,11 @@ inline void InitResizeData(HWND hdlg, const ANCHOR rgAnchors[], size_t cAnchors,
 
     for (DWORD iAnchor = 0; iAnchor < cAnchors; iAnchor++)
     {
-        GetWindowRectInClient(GetDlgItem(hdlg, rgAnchors[iAnchor].idControl), &rgAnchorOffsets[iAnchor]);
+        RECT rcControl;
+        GetWindowRectInClient(GetDlgItem(hdlg, rgAnchors[iAnchor].idControl), &rcControl);
 
-        switch (rgAnchors[iAnchor].aff & AF_LEFT_AND_RIGHT)
-        {
-        case AF_LEFT_AND_RIGHT:
-            rgAnchorOffsets[iAnchor].left -= rcClient.left;    // offset
-            rgAnchorOffsets[iAnchor].right -= rcClient.right;  // offset
-            break;
-
-        case AF_RIGHT:
-            rgAnchorOffsets[iAnchor].left = rgAnchorOffsets[iAnchor].right - rgAnchorOffsets[iAnchor].left;  // width
-            rgAnchorOffsets[iAnchor].right -= rcClient.right;  // offset
-            break;
-        }
-
-        switch (rgAnchors[iAnchor].aff & AF_TOP_AND_BOTTOM)
-        {
-        case AF_TOP_AND_BOTTOM:
-            rgAnchorOffsets[iAnchor].top -= rcClient.top;       // offset
-            rgAnchorOffsets[iAnchor].bottom -= rcClient.bottom; // offset
-            break;
-
-        case AF_BOTTOM:
-            rgAnchorOffsets[iAnchor].top = rgAnchorOffsets[iAnchor].bottom - rgAnchorOffsets[iAnchor].top;   // height
-            rgAnchorOffsets[iAnchor].bottom -= rcClient.bottom; // offset
-            break;
-        }
+        const auto offsets = win32app::anchor_offsets(static_cast<uint8_t>(rgAnchors[iAnchor].aff), ToLayoutRect(rcControl), ToLayoutRect(rcClient));
+        rgAnchorOffsets[iAnchor] = { offsets.left, offsets.top, offsets.right, offsets.bottom };
     }
 }
 
@@ -104,42 +108,242 @@ inline void OnSize(HWND hdlg, const ANCHOR rgAnchors[], size_t cAnchors, const R
         RECT rcClient;
         GetClientRect(hdlg, &rcClient);
 
-        for (DWORD iAnchor = 0; iAnchor < cAnchors; iAnchor++)
+        for (DWORD iAnchor = 0; hdwp && (iAnchor < cAnchors); iAnchor++)
         {
             const HWND hwndControl = GetDlgItem(hdlg, rgAnchors[iAnchor].idControl);
-            RECT rcNewPos;
-            GetWindowRectInClient(hwndControl, &rcNewPos);
-            const ANCHOR &anchor = rgAnchors[iAnchor];
-            switch (anchor.aff & AF_LEFT_AND_RIGHT)
-            {
-            case AF_RIGHT:
-                rcNewPos.right = rcClient.right + rgAnchorOffsets[iAnchor].right;
-                rcNewPos.left = rcNewPos.right - rgAnchorOffsets[iAnchor].left; // rgAnchorOffsets[iAnchor].left contains the width of the control
-                break;
-            case AF_LEFT_AND_RIGHT:
-                rcNewPos.right = rcClient.right + rgAnchorOffsets[iAnchor].right;
-                break;
-            }
 
-            switch (anchor.aff & AF_TOP_AND_BOTTOM)
+            RECT rcCurrent;
+            GetWindowRectInClient(hwndControl, &rcCurrent);
+            const auto rcNewPos = win32app::anchor_far_edges(static_cast<uint8_t>(rgAnchors[iAnchor].aff), ToLayoutRect(rgAnchorOffsets[iAnchor]), ToLayoutRect(rcClient), ToLayoutRect(rcCurrent));
+            if (ToLayoutRect(rcCurrent) != rcNewPos)
             {
-            case AF_BOTTOM:
-                rcNewPos.bottom = rcClient.bottom + rgAnchorOffsets[iAnchor].bottom;
-                rcNewPos.top = rcNewPos.bottom - rgAnchorOffsets[iAnchor].top; // rgAnchorOffsets[iAnchor].top contains the height of the control
-                break;
-            case AF_TOP_AND_BOTTOM:
-                rcNewPos.bottom = rcClient.bottom + rgAnchorOffsets[iAnchor].bottom;
-                break;
+                // all the moves are committed together by EndDeferWindowPos, each control is moved and painted once
+                hdwp = DeferWindowPos(hdwp, hwndControl, 0, rcNewPos.left, rcNewPos.top, rcNewPos.right - rcNewPos.left,  rcNewPos.bottom - rcNewPos.top, SWP_NOZORDER | SWP_NOACTIVATE);
             }
+        }
+        if (hdwp)
+        {
+            EndDeferWindowPos(hdwp);
+        }
+    }
+}
+
+// Alternative to the RECT array form that keeps the layout between calls. Controls whose position does not
+// change are not touched, not even to read their position, and the layout itself is done by
+// win32app::anchor_layout (anchor_layout.h). Unlike the RECT array form every control is placed from the position
+// InitResizeData recorded, a control the app moves afterwards is moved back on the next WM_SIZE.
+// Declare an ANCHOR_LAYOUT in place of m_anchorOffsets
+//
+//      ANCHOR_LAYOUT m_anchorLayout;
+//
+//      case WM_SIZE:
+//          OnSize(_hdlg, &m_anchorLayout);
+//          break;
+//
+//      case WM_INITDIALOG:
+//          InitResizeData(_hdlg, c_anchors, ARRAYSIZE(c_anchors), &m_anchorLayout);
+//          break;
+struct ANCHOR_LAYOUT
+{
+    std::vector<HWND> controls; // resolved once by InitResizeData
+    win32app::anchor_layout layout;
+    win32app::resize_throttle throttle; // see OnResizeMessage
+    bool initialized{}; // set by InitResizeData, see OnResizeMessage
+};
+
+inline void InitResizeData(HWND hdlg, const ANCHOR rgAnchors[], size_t cAnchors, _Out_ ANCHOR_LAYOUT* pLayout)
+{
+    RECT rcClient = {};
+    GetClientRect(hdlg, &rcClient);
+
+    *pLayout = {};
+    pLayout->controls.reserve(cAnchors);
+    pLayout->throttle.set_frame_interval(GetDisplayFrameInterval(hdlg));
+    for (DWORD iAnchor = 0; iAnchor < cAnchors; iAnchor++)
+    {
+        const HWND hwndControl = GetDlgItem(hdlg, rgAnchors[iAnchor].idControl);
+        RECT rcControl;
+        GetWindowRectInClient(hwndControl, &rcControl);
+
+        pLayout->controls.push_back(hwndControl);
+        pLayout->layout.add(static_cast<uint8_t>(rgAnchors[iAnchor].aff), ToLayoutRect(rcControl), ToLayoutRect(rcClient));
+    }
+    pLayout->initialized = true;
+}
+
+inline void OnSize(HWND hdlg, ANCHOR_LAYOUT* pLayout)
+{
+    RECT rcClient;
+    GetClientRect(hdlg, &rcClient);
+
+    const auto changed = pLayout->layout.update(ToLayoutRect(rcClient));
+    if (changed.empty())
+    {
+        return;
+    }
+
+    HDWP hdwp = BeginDeferWindowPos(static_cast<UINT>(changed.size()));
+    for (size_t i = 0; hdwp && (i < changed.size()); i++)
+    {
+        const auto& rcNewPos = pLayout->layout.rect(changed[i]);
+        hdwp = DeferWindowPos(hdwp, pLayout->controls[changed[i]], 0, rcNewPos.left, rcNewPos.top,
+            rcNewPos.right - rcNewPos.left, rcNewPos.bottom - rcNewPos.top, SWP_NOZORDER | SWP_NOACTIVATE);
+    }
+    if (hdwp)
+    {
+        EndDeferWindowPos(hdwp);
+    }
+}
+
+// Constraint based form, for proportional layouts, minimum and maximum sizes and DPI changes, see
+// constraint_layout.h. The table is built at compile time and layout does not allocate.
+//
+//      static constexpr auto c_columns = win32app::stack_constraints<2>(win32app::stack_orientation::horizontal);
+//      static constexpr CONSTRAINT c_constraints[] =
+//      {
+//          { IDC_LEFT_PANE,    c_columns[0] },
+//          { IDC_RIGHT_PANE,   c_columns[1].with_min_size(200, 0) },
+//          { IDC_OK,           win32app::from_anchor(AF_RIGHT | AF_BOTTOM) },
+//      };
+//      CONSTRAINT_LAYOUT<ARRAYSIZE(c_constraints)> m_constraintLayout;
+//
+//      case WM_SIZE:
+//          OnSize(_hdlg, &m_constraintLayout);
+//          break;
+//
+//      case WM_INITDIALOG:
+//          InitResizeData(_hdlg, c_constraints, &m_constraintLayout);
+//          break;
+struct CONSTRAINT
+{
+    DWORD idControl;
+    win32app::layout_constraint constraint;
+};
+
+template <size_t cConstraints>
+struct CONSTRAINT_LAYOUT
+{
+    std::array<HWND, cConstraints> controls{}; // resolved once by InitResizeData
+    win32app::constraint_table<cConstraints> table;
+    std::array<win32app::layout_rect, cConstraints> current{};
+    win32app::resize_throttle throttle; // see OnResizeMessage
+    bool initialized{}; // WM_SIZE can arrive before WM_INITDIALOG, there is nothing to lay out until then
+};
 
-            MoveWindow(hwndControl, rcNewPos.left, rcNewPos.top, rcNewPos.right - rcNewPos.left,  rcNewPos.bottom - rcNewPos.top, TRUE);
+template <size_t cConstraints>
+inline void InitResizeData(HWND hdlg, const CONSTRAINT (&rgConstraints)[cConstraints], _Out_ CONSTRAINT_LAYOUT<cConstraints>* pLayout)
+{
+    RECT rcClient = {};
+    GetClientRect(hdlg, &rcClient);
+
+    *pLayout = {};
+    pLayout->throttle.set_frame_interval(GetDisplayFrameInterval(hdlg));
+    for (size_t iConstraint = 0; iConstraint < cConstraints; iConstraint++)
+    {
+        const HWND hwndControl = GetDlgItem(hdlg, rgConstraints[iConstraint].idControl);
+        RECT rcControl;
+        GetWindowRectInClient(hwndControl, &rcControl);
+
+        pLayout->controls[iConstraint] = hwndControl;
+        pLayout->table.constraints[iConstraint] = rgConstraints[iConstraint].constraint;
+        pLayout->current[iConstraint] = ToLayoutRect(rcControl);
+    }
+    pLayout->table.record(pLayout->current, ToLayoutRect(rcClient), static_cast<int32_t>(GetDpiForWindow(hdlg)));
+    pLayout->initialized = true;
+}
+
+template <size_t cConstraints>
+inline void OnSize(HWND hdlg, CONSTRAINT_LAYOUT<cConstraints>* pLayout)
+{
+    if (!pLayout->initialized)
+    {
+        return;
+    }
+
+    RECT rcClient;
+    GetClientRect(hdlg, &rcClient);
+    const auto rects = pLayout->table.compute(ToLayoutRect(rcClient), static_cast<int32_t>(GetDpiForWindow(hdlg)));
 
-            DeferWindowPos(hdwp, hwndControl, 0, rcNewPos.left, rcNewPos.top, rcNewPos.right - rcNewPos.left,  rcNewPos.bottom - rcNewPos.top, SWP_NOZORDER | SWP_NOACTIVATE);
+    HDWP hdwp = BeginDeferWindowPos(static_cast<UINT>(cConstraints));
+    for (size_t iConstraint = 0; hdwp && (iConstraint < cConstraints); iConstraint++)
+    {
+        const auto& rcNewPos = rects[iConstraint];
+        if (rcNewPos != pLayout->current[iConstraint])
+        {
+            pLayout->current[iConstraint] = rcNewPos;
+            hdwp = DeferWindowPos(hdwp, pLayout->controls[iConstraint], 0, rcNewPos.left, rcNewPos.top,
+                rcNewPos.right - rcNewPos.left, rcNewPos.bottom - rcNewPos.top, SWP_NOZORDER | SWP_NOACTIVATE);
         }
+    }
+    if (hdwp)
+    {
         EndDeferWindowPos(hdwp);
     }
 }
 
+// Alternative to calling OnSize from WM_SIZE for the ANCHOR_LAYOUT and CONSTRAINT_LAYOUT forms that keeps
+// interactive resizing smooth for dialogs with many controls. While the user drags the border layout is
+// limited to once per display frame, and the final size is laid out exactly when the drag ends.
+// Returns true if the message was handled. The timer with the id RESIZE_LAYOUT_TIMER_ID is used.
+// Messages that arrive before InitResizeData, WM_SIZE during dialog creation for example, are not handled
+// and do not touch the throttle, InitResizeData would discard its state.
+//
+//      default:
+//          if (OnResizeMessage(_hdlg, uMsg, wParam, &m_anchorLayout)) return TRUE;
+//          break;
+constexpr UINT_PTR RESIZE_LAYOUT_TIMER_ID = 0x524C; // 'RL'
+
+template <typename TLayout>
+inline bool OnResizeMessage(HWND hdlg, UINT uMsg, WPARAM wParam, TLayout* pLayout)
+{
+    if (!pLayout->initialized)
+    {
+        return false;
+    }
+
+    switch (uMsg)
+    {
+    case WM_ENTERSIZEMOVE:
+        pLayout->throttle.enter_size_move();
+        return true;
+
+    case WM_SIZE:
+        if (wParam != SIZE_MINIMIZED)
+        {
+            const auto decision = pLayout->throttle.size_changed(std::chrono::steady_clock::now());
+            if (decision.layout)
+            {
+                OnSize(hdlg, pLayout);
+            }
+            if (decision.arm_timer)
+            {
+                const auto delay = std::chrono::ceil<std::chrono::milliseconds>(decision.timer_delay).count();
+                SetTimer(hdlg, RESIZE_LAYOUT_TIMER_ID, static_cast<UINT>(delay), nullptr);
+            }
+        }
+        return true;
+
+    case WM_TIMER:
+        if (wParam != RESIZE_LAYOUT_TIMER_ID)
+        {
+            return false;
+        }
+        KillTimer(hdlg, RESIZE_LAYOUT_TIMER_ID); // one shot
+        if (pLayout->throttle.timer_elapsed(std::chrono::steady_clock::now()))
+        {
+            OnSize(hdlg, pLayout);
+        }
+        return true;
+
+    case WM_EXITSIZEMOVE:
+        KillTimer(hdlg, RESIZE_LAYOUT_TIMER_ID);
+        pLayout->throttle.exit_size_move();
+        OnSize(hdlg, pLayout);
+        return true;
+    }
+    return false;
+}
+
 // Make the UI look nice but using the v6 common controls
 // Set up common controls v6 the easy way.  By doing this, there is no need
 // to call InitCommonControlsEx().
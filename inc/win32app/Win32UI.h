@@ -4,26 +4,104 @@
 #include <string>
 #include <cassert>
 #include <wil/common.h>
+#include <wil/resource.h>
+
+#include "window_snapshot.h"
+#include "window_index.h"
+#include "string_pool.h"
 
 // This tells the linker to generate the manifest entires that use comclt32 v6.
 // This makes Win32 controls based UIs look less bad.
 #pragma comment(linker,"/manifestdependency:\"type='win32' name='Microsoft.Windows.Common-Controls' version='6.0.0.0' processorArchitecture='*' publicKeyToken='6595b64144ccf1df' language='*'\"")
 
+// Reads the title into an inline buffer, one call for titles shorter than Capacity. Longer titles are
+// read again into a heap buffer of their length.
+template <size_t Capacity = 128>
+win32app::small_wstring<Capacity> GetWindowTextSmall(HWND window)
+{
+    win32app::small_wstring<Capacity> result;
+    auto length = GetWindowTextW(window, result.data(), static_cast<int>(result.capacity()));
+    if (static_cast<size_t>(length) + 1 >= result.capacity()) // possibly truncated
+    {
+        result.reserve(static_cast<size_t>(GetWindowTextLengthW(window)) + 1);
+        length = GetWindowTextW(window, result.data(), static_cast<int>(result.capacity()));
+    }
+    result.resize(static_cast<size_t>(length));
+    return result;
+}
+
 inline std::wstring GetWindowTextAlloc(HWND window)
 {
-    const auto length = GetWindowTextLengthW(window) + 1; // with space for null
-    std::wstring result(length, L'\0');
-    const auto retrievedSize = GetWindowTextW(window, result.data(), static_cast<int>(result.capacity()));
-    result.resize(result.size() - 1); // trim null terminator
-    assert(result.size() == wcslen(result.c_str()));
+    const auto text = GetWindowTextSmall(window);
+    return std::wstring(text.view());
+}
+
+// Class names are at most 256 characters.
+inline win32app::small_wstring<257> GetWindowClassSmall(HWND window)
+{
+    win32app::small_wstring<257> result;
+    result.resize(static_cast<size_t>(GetClassNameW(window, result.data(), static_cast<int>(result.capacity()))));
     return result;
 }
 
 inline std::wstring GetWindowClassAlloc(HWND window)
 {
-    std::wstring result(64, L'\0');
-    result.resize(GetClassNameW(window, result.data(), static_cast<int>(result.size())));
-    return result;
+    const auto name = GetWindowClassSmall(window);
+    return std::wstring(name.view());
+}
+
+inline win32app::class_name_cache& GetWindowClassNameCache()
+{
+    static win32app::class_name_cache s_cache;
+    return s_cache;
+}
+
+// The class name from a process wide cache keyed by the class atom, only the first window of each class
+// has its name read. Empty if the window no longer exists. An atom can be reused after its class is
+// unregistered, this is meant for enumerating windows, not identifying classes that come and go.
+inline std::wstring_view GetWindowClassCached(HWND window)
+{
+    const auto atom = static_cast<uint16_t>(GetClassWord(window, GCW_ATOM));
+    if (atom == 0)
+    {
+        return {};
+    }
+    return GetWindowClassNameCache().get(atom, [&] { return GetWindowClassSmall(window); });
+}
+
+// Reads the titles of windows into pool, in order, titles are appended without an allocation per window.
+// Titles longer than maxLength are read again at their length.
+inline void GetWindowTexts(std::span<const HWND> windows, win32app::string_pool& pool, size_t maxLength = 127)
+{
+    pool.reserve(pool.size() + windows.size(), windows.size() * 32);
+    for (auto window : windows)
+    {
+        size_t written{};
+        pool.append_with(maxLength, [&](wchar_t* buffer, size_t capacity)
+        {
+            written = static_cast<size_t>(GetWindowTextW(window, buffer, static_cast<int>(capacity)));
+            return written;
+        });
+        if (written >= maxLength) // possibly truncated
+        {
+            pool.pop_back();
+            pool.append_with(static_cast<size_t>(GetWindowTextLengthW(window)), [&](wchar_t* buffer, size_t capacity)
+            {
+                return static_cast<size_t>(GetWindowTextW(window, buffer, static_cast<int>(capacity)));
+            });
+        }
+    }
+}
+
+// The class names of windows, in order, from the cache.
+inline void GetWindowClassNames(std::span<const HWND> windows, std::vector<std::wstring_view>& names)
+{
+    names.clear();
+    names.reserve(windows.size());
+    for (auto window : windows)
+    {
+        names.push_back(GetWindowClassCached(window));
+    }
 }
 
 inline void EnableProcessDefaults(PCWSTR mainThreadName = L"Main Thread")
@@ -48,20 +126,237 @@ inline bool IsAppLikeWindow(HWND window, HWND filterWindow = nullptr)
         return false;
     }
 
-    const auto style = GetWindowLongW(window, GWL_STYLE);
-    const auto exStyle = GetWindowLongW(window, GWL_EXSTYLE);
+    const auto style = static_cast<uint32_t>(GetWindowLongW(window, GWL_STYLE));
+    const auto exStyle = static_cast<uint32_t>(GetWindowLongW(window, GWL_EXSTYLE));
 
-    // This expression implements the policy of skipping windows unless they are visible,
-    // not minimized, not tool windows, can take activation and have non-zero size.
+    // This implements the policy of skipping windows unless they are visible, not minimized, not tool
+    // windows, can take activation and have non-zero size, see win32app::is_app_like_window.
+    // The rect and owner are only retrieved when the styles pass.
     RECT windowRect{};
-    return WI_IsFlagSet(style, WS_VISIBLE) &&
-        WI_IsFlagClear(style, WS_MINIMIZE) &&
-        WI_AreAllFlagsClear(exStyle, WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE) &&
+    return win32app::is_app_like_style(style, exStyle) &&
         (GetWindowRect(window, &windowRect) != FALSE) &&
-        (windowRect.left != windowRect.right) && (windowRect.top != windowRect.bottom) &&
-        (GetWindow(window, GW_OWNER) == nullptr);
+        win32app::is_app_like_window(style, exStyle, { windowRect.left, windowRect.top, windowRect.right, windowRect.bottom },
+            reinterpret_cast<uint64_t>(GetWindow(window, GW_OWNER)));
 }
 
+// Captures the attributes IsAppLikeWindow uses for every top level window in one pass, for filtering
+// and diffing with the functions in window_snapshot.h instead of repeating the system calls.
+// The rect, owner and title are only retrieved for windows whose styles could be app like unless
+// allAttributes is true, the others have an empty rect, no owner and no title.
+inline win32app::window_snapshot CaptureTopLevelWindows(bool captureTitles = false, bool allAttributes = false)
+{
+    win32app::window_snapshot snapshot;
+    snapshot.reserve(1024);
+    ForEachTopLevelWindow([&](HWND window) -> BOOL
+    {
+        const auto style = static_cast<uint32_t>(GetWindowLongW(window, GWL_STYLE));
+        const auto exStyle = static_cast<uint32_t>(GetWindowLongW(window, GWL_EXSTYLE));
+        RECT windowRect{};
+        HWND owner{};
+        win32app::small_wstring<128> title;
+        if (allAttributes || win32app::is_app_like_style(style, exStyle))
+        {
+            GetWindowRect(window, &windowRect);
+            owner = GetWindow(window, GW_OWNER);
+            if (captureTitles)
+            {
+                title = GetWindowTextSmall(window);
+            }
+        }
+        snapshot.add(reinterpret_cast<uint64_t>(window), style, exStyle, { windowRect.left, windowRect.top, windowRect.right, windowRect.bottom },
+            reinterpret_cast<uint64_t>(owner), title.view());
+        return TRUE;
+    });
+    return snapshot;
+}
+
+inline HWND ToWindowHandle(uint64_t handle)
+{
+    return reinterpret_cast<HWND>(handle);
+}
+
+// Keeps a win32app::window_index of the top level windows current from window events (SetWinEventHook)
+// instead of polling, see window_index.h. Events are coalesced and applied in a batch batchDelayMs after
+// the first event of the batch.
+// Start() must be called on a thread that pumps messages, the events and batches are handled there and
+// the index and subscribers are used there. One instance per thread.
+class LiveWindowIndex
+{
+public:
+    explicit LiveWindowIndex(UINT batchDelayMs = 50, bool captureTitles = true) :
+        m_batchDelayMs(batchDelayMs), m_captureTitles(captureTitles)
+    {
+    }
+
+    ~LiveWindowIndex()
+    {
+        Stop();
+    }
+
+    LiveWindowIndex(const LiveWindowIndex&) = delete;
+    LiveWindowIndex& operator=(const LiveWindowIndex&) = delete;
+
+    // Installs the hooks and indexes the current top level windows.
+    void Start()
+    {
+        assert(t_instance == nullptr);
+        t_instance = this;
+        m_objectHook.reset(SetWinEventHook(EVENT_OBJECT_CREATE, EVENT_OBJECT_NAMECHANGE, nullptr, OnWinEvent, 0, 0, WINEVENT_OUTOFCONTEXT));
+        THROW_LAST_ERROR_IF_NULL(m_objectHook.get());
+        m_minimizeHook.reset(SetWinEventHook(EVENT_SYSTEM_MINIMIZESTART, EVENT_SYSTEM_MINIMIZEEND, nullptr, OnWinEvent, 0, 0, WINEVENT_OUTOFCONTEXT));
+        THROW_LAST_ERROR_IF_NULL(m_minimizeHook.get());
+
+        ForEachTopLevelWindow([&](HWND window) -> BOOL
+        {
+            m_queue.post(reinterpret_cast<uint64_t>(window), win32app::window_created);
+            return TRUE;
+        });
+        Flush();
+    }
+
+    void Stop()
+    {
+        m_objectHook.reset();
+        m_minimizeHook.reset();
+        if (m_timer)
+        {
+            KillTimer(nullptr, std::exchange(m_timer, 0));
+        }
+        if (t_instance == this)
+        {
+            t_instance = nullptr;
+        }
+    }
+
+    // Applies the pending events now rather than when the batch delay expires.
+    win32app::window_index_changes Flush()
+    {
+        // The batch is taken now, the timer would fire for an empty one, or a new batch would arm a second timer.
+        if (m_timer)
+        {
+            KillTimer(nullptr, std::exchange(m_timer, 0));
+        }
+        return m_index.apply(m_queue.take(), [this](uint64_t handle, uint8_t events, win32app::window_attributes& attributes)
+        {
+            return Query(ToWindowHandle(handle), events, attributes);
+        });
+    }
+
+    const win32app::window_index& Index() const
+    {
+        return m_index;
+    }
+
+    std::vector<HWND> AppLikeWindows(HWND filterWindow = nullptr) const
+    {
+        std::vector<HWND> result;
+        for (auto handle : m_index.app_like_windows(reinterpret_cast<uint64_t>(filterWindow)))
+        {
+            result.push_back(ToWindowHandle(handle));
+        }
+        return result;
+    }
+
+    size_t Subscribe(win32app::window_index::subscriber callback)
+    {
+        return m_index.subscribe(std::move(callback));
+    }
+
+    void Unsubscribe(size_t id)
+    {
+        m_index.unsubscribe(id);
+    }
+
+    // The events received and the windows they were coalesced into, to see the effect of batching.
+    size_t EventsPosted() const
+    {
+        return m_queue.posted();
+    }
+
+private:
+    static uint8_t ToWindowEvent(DWORD event)
+    {
+        switch (event)
+        {
+        case EVENT_OBJECT_CREATE: return win32app::window_created;
+        case EVENT_OBJECT_DESTROY: return win32app::window_destroyed;
+        case EVENT_OBJECT_SHOW: return win32app::window_shown;
+        case EVENT_OBJECT_HIDE: return win32app::window_hidden;
+        case EVENT_OBJECT_NAMECHANGE: return win32app::window_name_changed;
+        case EVENT_OBJECT_LOCATIONCHANGE: return win32app::window_location_changed;
+        case EVENT_SYSTEM_MINIMIZESTART:
+        case EVENT_SYSTEM_MINIMIZEEND: return win32app::window_style_changed;
+        }
+        return 0;
+    }
+
+    static void CALLBACK OnWinEvent(HWINEVENTHOOK, DWORD event, HWND window, LONG idObject, LONG idChild, DWORD, DWORD)
+    {
+        const auto windowEvent = ToWindowEvent(event);
+        if (!t_instance || !window || (idObject != OBJID_WINDOW) || (idChild != CHILDID_SELF) || (windowEvent == 0))
+        {
+            return;
+        }
+        // Destroyed windows can no longer be checked, the index ignores the ones it does not have.
+        if ((windowEvent != win32app::window_destroyed) && (GetAncestor(window, GA_PARENT) != GetDesktopWindow()))
+        {
+            return;
+        }
+        if (t_instance->m_queue.post(reinterpret_cast<uint64_t>(window), windowEvent))
+        {
+            t_instance->m_timer = SetTimer(nullptr, 0, t_instance->m_batchDelayMs, OnBatchTimer);
+        }
+    }
+
+    static void CALLBACK OnBatchTimer(HWND, UINT, UINT_PTR id, DWORD)
+    {
+        KillTimer(nullptr, id);
+        if (t_instance)
+        {
+            t_instance->m_timer = 0;
+            t_instance->Flush();
+        }
+    }
+
+    bool Query(HWND window, uint8_t events, win32app::window_attributes& attributes) const
+    {
+        if (!IsWindow(window))
+        {
+            return false;
+        }
+        if (events & win32app::window_event_reads::styles)
+        {
+            attributes.style = static_cast<uint32_t>(GetWindowLongW(window, GWL_STYLE));
+            attributes.exStyle = static_cast<uint32_t>(GetWindowLongW(window, GWL_EXSTYLE));
+        }
+        if (events & win32app::window_event_reads::rect)
+        {
+            RECT windowRect{};
+            GetWindowRect(window, &windowRect);
+            attributes.rect = { windowRect.left, windowRect.top, windowRect.right, windowRect.bottom };
+        }
+        if (events & win32app::window_event_reads::owner)
+        {
+            attributes.owner = reinterpret_cast<uint64_t>(GetWindow(window, GW_OWNER));
+        }
+        if (m_captureTitles && (events & win32app::window_event_reads::title))
+        {
+            attributes.title = GetWindowTextSmall(window).view();
+        }
+        return true;
+    }
+
+    inline static thread_local LiveWindowIndex* t_instance{};
+
+    const UINT m_batchDelayMs;
+    const bool m_captureTitles;
+    win32app::window_event_queue m_queue;
+    win32app::window_index m_index;
+    wil::unique_hwineventhook m_objectHook;
+    wil::unique_hwineventhook m_minimizeHook;
+    UINT_PTR m_timer{};
+};
+
 inline void ReplaceWindowIcon(HWND hwnd, BOOL fSmall, HICON hIcon)
 {
     hIcon = (HICON)SendMessageW(hwnd, WM_SETICON, fSmall ? ICON_SMALL : ICON_BIG, (LPARAM)hIcon);
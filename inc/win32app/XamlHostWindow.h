@@ -6,7 +6,9 @@
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 #include <windows.h>
+#include <commctrl.h>
 #undef GetCurrentTime
+#pragma comment(lib, "comctl32.lib")
 
 #include <wil/win32_helpers.h>
 #include <wil/cppwinrt_helpers.h>
@@ -22,6 +24,7 @@
 
 #include <windows.ui.xaml.hosting.desktopwindowxamlsource.h> // COM interop
 
+#include <atomic>
 #include <mutex>
 
 #include <wil/resource.h>
@@ -29,6 +32,154 @@
 #include "win32_app_helpers.h"
 #include "reference_waiter.h"
 #include "utf8_helpers.h"
+#include "embedded_resources.h"
+#include "fan_out_join.h"
+#include "snapshot_registry.h"
+#include "ui_thread_placement.h"
+#include "ui_session.h"
+#include "work_stealing_pool.h"
+#include "shutdown_tracker.h"
+
+// The dispatcher thread started by XamlHostWindow::Prewarm, Xaml is initialized on it and kept initialized
+// by xamlManager. The next XamlHostWindow::StartThreadAsync or XamlWindowThreadPool takes it.
+struct XamlPrewarmedThread
+{
+    winrt::Windows::System::DispatcherQueueController queueController{nullptr};
+    winrt::Windows::UI::Xaml::Hosting::WindowsXamlManager xamlManager{nullptr}; // used on the thread of queueController
+
+    static void Publish(std::shared_ptr<XamlPrewarmedThread> warm)
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        s_warm = std::move(warm);
+    }
+
+    // Empty if Prewarm was not called or the thread was taken.
+    static std::shared_ptr<XamlPrewarmedThread> Take()
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        return std::move(s_warm);
+    }
+
+    // Closes the WindowsXamlManager on its thread, after the work already queued there. Queue this before the
+    // queue is shut down, the shutdown runs the queued work.
+    static void CloseOnThread(std::shared_ptr<XamlPrewarmedThread> warm)
+    {
+        auto queue = warm->queueController.DispatcherQueue();
+        queue.TryEnqueue([warm = std::move(warm)]() {
+            if (auto xamlManager = std::exchange(warm->xamlManager, nullptr))
+            {
+                xamlManager.Close();
+            }
+        });
+    }
+
+private:
+    inline static std::mutex s_lock;
+    inline static std::shared_ptr<XamlPrewarmedThread> s_warm;
+};
+
+// Hosts windows on a fixed set of UI threads instead of a dedicated thread per window, for apps
+// with many windows. Threads are chosen by win32app::ui_thread_placement, see ui_thread_placement.h,
+// from the work queued by RunAsync and the time the windows and their islands spend handling messages.
+// The pool must outlive its windows. The first thread is the one started by XamlHostWindow::Prewarm if it
+// was not used yet, Xaml stays initialized on it until the pool shuts down.
+//
+//    inline static XamlWindowThreadPool s_pool{4};
+//
+//    s_pool.StartWindowAsync([](auto&& queueController, auto&& slot) {
+//        auto window = std::make_shared<XamlHostWindow>(std::move(queueController), std::move(slot));
+//        window->Show(SW_SHOWNORMAL);
+//    });
+struct XamlWindowThreadPool
+{
+    explicit XamlWindowThreadPool(size_t threadCount, win32app::placement_policy policy = win32app::placement_policy::least_loaded) :
+        m_placement(threadCount, policy)
+    {
+        m_queueControllers.reserve(threadCount);
+        if (threadCount != 0)
+        {
+            m_prewarmed = XamlPrewarmedThread::Take();
+        }
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            m_queueControllers.emplace_back(((i == 0) && m_prewarmed) ? m_prewarmed->queueController
+                                                                      : winrt::Windows::System::DispatcherQueueController::CreateOnDedicatedThread());
+        }
+    }
+
+    // fn(DispatcherQueueController, ui_thread_placement::window_slot) runs on the thread chosen for the window.
+    // Windows with the same affinityGroup share a thread.
+    template <typename Lambda>
+    winrt::fire_and_forget StartWindowAsync(Lambda fn, std::optional<uint32_t> affinityGroup = std::nullopt)
+    {
+        auto slot = m_placement.place(affinityGroup);
+        auto queueController = m_queueControllers[slot.thread()];
+        co_await wil::resume_foreground(queueController.DispatcherQueue());
+        fn(std::move(queueController), std::move(slot));
+    }
+
+    // Shuts the threads down if ShutdownAsync was not used, waiting for them unless called on one of them.
+    ~XamlWindowThreadPool()
+    {
+        if (auto warm = std::move(m_prewarmed))
+        {
+            XamlPrewarmedThread::CloseOnThread(std::move(warm));
+        }
+        std::vector<winrt::Windows::Foundation::IAsyncAction> shutdowns;
+        for (auto& queueController : m_queueControllers)
+        {
+            try
+            {
+                auto shutdown = queueController.ShutdownQueueAsync();
+                if (!queueController.DispatcherQueue().HasThreadAccess())
+                {
+                    shutdowns.emplace_back(std::move(shutdown));
+                }
+            }
+            CATCH_LOG();
+        }
+        for (auto& shutdown : shutdowns)
+        {
+            try
+            {
+                shutdown.get();
+            }
+            CATCH_LOG();
+        }
+    }
+
+    XamlWindowThreadPool(const XamlWindowThreadPool&) = delete;
+    XamlWindowThreadPool& operator=(const XamlWindowThreadPool&) = delete;
+
+    win32app::ui_thread_load Load(size_t thread) const
+    {
+        return m_placement.load(thread);
+    }
+
+    winrt::Windows::System::DispatcherQueue DispatcherQueue(size_t thread) const
+    {
+        return m_queueControllers[thread].DispatcherQueue();
+    }
+
+    // Call after the windows are closed, no windows can be started after this.
+    winrt::Windows::Foundation::IAsyncAction ShutdownAsync()
+    {
+        if (auto warm = std::move(m_prewarmed))
+        {
+            XamlPrewarmedThread::CloseOnThread(std::move(warm));
+        }
+        auto queueControllers = std::move(m_queueControllers);
+        for (auto& queueController : queueControllers)
+        {
+            co_await queueController.ShutdownQueueAsync();
+        }
+    }
+
+private:
+    win32app::ui_thread_placement m_placement;
+    std::vector<winrt::Windows::System::DispatcherQueueController> m_queueControllers;
+    std::shared_ptr<XamlPrewarmedThread> m_prewarmed; // the first thread, if it was started by Prewarm
+};
 
 struct XamlHostWindow : public std::enable_shared_from_this<XamlHostWindow>
 {
@@ -40,10 +191,78 @@ struct XamlHostWindow : public std::enable_shared_from_this<XamlHostWindow>
         // The Application must be created early in the lifetime so that
         // Xaml does not create it on demand later.
         wil::init_once(m_initOnce, []() {
+            WIN32APP_TRACE_SCOPE("Xaml Application");
             s_app = winrt::Windows::UI::Xaml::Application();
         });
     }
 
+    // Starts the work needed before the first window concurrently, call early in wWinMain (after
+    // UseEmbeddedResources if that is used). A dispatcher thread creates the Application and a
+    // WindowsXamlManager, the first window started with StartThreadAsync, or the first thread of an
+    // XamlWindowThreadPool, runs on that thread. The window class is registered and the markup decoded
+    // on the background pool. Only the first call has an effect. If the thread may not be used, call
+    // ShutdownPrewarmed at exit, wait_until_zero, wait_until_zero_for and WaitForShutdown do not.
+    static void Prewarm()
+    {
+        std::call_once(s_prewarmOnce, []() {
+            auto warm = std::make_shared<XamlPrewarmedThread>();
+            warm->queueController = winrt::Windows::System::DispatcherQueueController::CreateOnDedicatedThread();
+            warm->queueController.DispatcherQueue().TryEnqueue([warm]() {
+                WIN32APP_TRACE_SCOPE("Prewarm Xaml");
+                try
+                {
+                    EnsureAppInitialized();
+                    warm->xamlManager = winrt::Windows::UI::Xaml::Hosting::WindowsXamlManager::InitializeForCurrentThread();
+                }
+                CATCH_LOG();
+            });
+            XamlPrewarmedThread::Publish(std::move(warm));
+            PrewarmBackground();
+        });
+    }
+
+    // Shuts down the thread started by Prewarm if no window used it, its WindowsXamlManager is closed on that
+    // thread rather than released by static destruction after the thread is gone. Call it at exit, before
+    // waiting for the windows.
+    static void ShutdownPrewarmed()
+    {
+        if (auto warm = XamlPrewarmedThread::Take())
+        {
+            auto queueController = warm->queueController;
+            XamlPrewarmedThread::CloseOnThread(std::move(warm));
+            queueController.ShutdownQueueAsync().get();
+        }
+    }
+
+    // Use UTF-16 resources generated by Tools/embed_utf16_resources.cpp in place of the UTF-8 module
+    // resources of the same name. Call this before Prewarm and before creating the first window.
+    static void UseEmbeddedResources(const win32app::embedded_resource_table& table)
+    {
+        s_embeddedResources.store(&table, std::memory_order_release);
+    }
+
+private:
+    static void PrewarmBackground()
+    {
+        BackgroundPool().submit([]() {
+            WIN32APP_TRACE_SCOPE("Prewarm window class");
+            win32app::register_window_class<XamlHostWindow>(c_windowClassName);
+        });
+        if (!s_embeddedResources.load(std::memory_order_acquire))
+        {
+            BackgroundPool().submit([]() {
+                WIN32APP_TRACE_SCOPE("Prewarm resources");
+                try
+                {
+                    get_decoded_resource_view(L"AppWindow.xaml", RT_RCDATA);
+                }
+                CATCH_LOG();
+            });
+        }
+    }
+
+public:
+
     template<typename TLambda>
     static void RunOnUIThread(TLambda fn, bool closeWindowWhenDone = true)
     {
@@ -84,15 +303,151 @@ struct XamlHostWindow : public std::enable_shared_from_this<XamlHostWindow>
             appWindow->RunAsync([](auto& window) noexcept { window.m_window.reset(); }).get();
         }
 
+        XamlHostWindow::ShutdownPrewarmed();
         XamlHostWindow::wait_until_zero();
     }
 
+    // The Xaml backend of win32app::ui_session, see ui_session.h. For callers that run many short functions
+    // on a UI thread, RunOnUIThread starts a thread and creates a window for each call, a session reuses them.
+    // The window is hosted on a single thread XamlWindowThreadPool so closing it leaves the thread running.
+    // The backend holds a WindowsXamlManager on the thread, Xaml stays initialized when the window closes
+    // its own manager.
+    //
+    //    win32app::ui_session<XamlHostWindow::SessionBackend> session;
+    //    session.run([](XamlHostWindow& window) { ... });
+    struct SessionBackend
+    {
+        void start_thread()
+        {
+            m_pool = std::make_unique<XamlWindowThreadPool>(1);
+            RunOnThread([this]() {
+                EnsureAppInitialized();
+                m_xamlManager = winrt::Windows::UI::Xaml::Hosting::WindowsXamlManager::InitializeForCurrentThread();
+            });
+        }
+
+        void stop_thread()
+        {
+            auto pool = std::move(m_pool);
+            if (m_xamlManager)
+            {
+                RunOnThread(*pool, [this]() { std::exchange(m_xamlManager, nullptr).Close(); });
+            }
+            pool->ShutdownAsync().get();
+        }
+
+        void create_window()
+        {
+            wil::unique_event windowRunning{wil::EventOptions::None};
+            std::exception_ptr error;
+
+            m_pool->StartWindowAsync([&](auto&& queueController, auto&& slot) {
+                try
+                {
+                    m_window = std::make_shared<XamlHostWindow>(std::move(queueController), std::move(slot));
+                    m_window->Show(SW_SHOWNORMAL);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                windowRunning.SetEvent();
+            });
+
+            windowRunning.wait();
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+        void destroy_window()
+        {
+            std::exchange(m_window, nullptr)->RunAsync([](auto& window) noexcept { window.m_window.reset(); }).get();
+        }
+
+        void reset_content()
+        {
+            m_window->RunAsync([](auto& window) { window.ResetContent(); }).get();
+        }
+
+        void log_current_exception() noexcept
+        {
+            LOG_CAUGHT_EXCEPTION();
+        }
+
+        template <typename Lambda>
+        void run(Lambda&& fn)
+        {
+            winrt::Windows::Foundation::IAsyncAction fnAction;
+            m_window->RunAsync([&](auto& window) {
+                    if constexpr (std::is_same_v<std::invoke_result_t<Lambda, XamlHostWindow&>, decltype(fnAction)>)
+                    {
+                        fnAction = fn(window);
+                    }
+                    else
+                    {
+                        fn(window);
+                    }
+                }).get();
+
+            if (fnAction)
+            {
+                fnAction.get();
+            }
+        }
+
+    private:
+        // Runs fn on the pool's thread and waits for it, rethrowing what it throws.
+        template <typename Lambda>
+        static void RunOnThread(XamlWindowThreadPool& pool, Lambda&& fn)
+        {
+            wil::unique_event done{wil::EventOptions::None};
+            std::exception_ptr error;
+            THROW_HR_IF(E_ABORT, !pool.DispatcherQueue(0).TryEnqueue([&]() {
+                try
+                {
+                    fn();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                done.SetEvent();
+            }));
+
+            done.wait();
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+        template <typename Lambda>
+        void RunOnThread(Lambda&& fn)
+        {
+            RunOnThread(*m_pool, std::forward<Lambda>(fn));
+        }
+
+        std::unique_ptr<XamlWindowThreadPool> m_pool;
+        std::shared_ptr<XamlHostWindow> m_window;
+        winrt::Windows::UI::Xaml::Hosting::WindowsXamlManager m_xamlManager{nullptr}; // used on the pool's thread
+    };
+
     XamlHostWindow(winrt::Windows::System::DispatcherQueueController queueController) : m_queueController(std::move(queueController))
     {
         EnsureAppInitialized();
+        WIN32APP_TRACE_SCOPE("WindowsXamlManager::InitializeForCurrentThread");
         m_xamlManager = winrt::Windows::UI::Xaml::Hosting::WindowsXamlManager::InitializeForCurrentThread();
     }
 
+    // For windows hosted by XamlWindowThreadPool, the thread and its queue are shared with other windows.
+    XamlHostWindow(winrt::Windows::System::DispatcherQueueController queueController, win32app::ui_thread_placement::window_slot threadSlot) :
+        XamlHostWindow(std::move(queueController))
+    {
+        m_threadSlot.emplace(std::move(threadSlot));
+    }
+
     LRESULT Create()
     {
         using namespace winrt::Windows::UI::Xaml;
@@ -107,14 +462,35 @@ struct XamlHostWindow : public std::enable_shared_from_this<XamlHostWindow>
         THROW_IF_FAILED(interop->AttachToWindow(m_window.get()));
         THROW_IF_FAILED(interop->get_WindowHandle(&m_xamlSourceWindow));
 
-        auto contentText = skip_utf8_bom(get_resource_view(L"AppWindow.xaml", RT_RCDATA));
-        auto contentTextWide = from_utf8(contentText);
-        auto content = winrt::Windows::UI::Xaml::Markup::XamlReader::Load(contentTextWide).as<winrt::Windows::UI::Xaml::UIElement>();
+        if (m_threadSlot)
+        {
+            // Input is handled by the island's window, time both for the load of the pool thread.
+            SetWindowSubclass(m_window.get(), TimeMessagesSubclassProc, 0, reinterpret_cast<DWORD_PTR>(this));
+            SetWindowSubclass(m_xamlSourceWindow, TimeMessagesSubclassProc, 0, reinterpret_cast<DWORD_PTR>(this));
+        }
+
+        ResetContent();
+        return 0;
+    }
+
+    // Replaces the content with a new instance of the window's markup.
+    void ResetContent()
+    {
+        using namespace winrt::Windows::UI::Xaml;
+        using namespace winrt::Windows::UI::Xaml::Controls;
+
+        // The markup is pre-transcoded at build time or decoded once per process, each window only parses it.
+        const auto embeddedResources = s_embeddedResources.load(std::memory_order_acquire);
+        auto contentText = embeddedResources ? embeddedResources->find(L"AppWindow.xaml") : std::wstring_view{};
+        if (contentText.empty())
+        {
+            contentText = get_decoded_resource_view(L"AppWindow.xaml", RT_RCDATA);
+        }
+        WIN32APP_TRACE_SCOPE("XamlReader::Load");
+        auto content = winrt::Windows::UI::Xaml::Markup::XamlReader::Load(contentText).as<UIElement>();
         m_xamlSource.Content(content);
 
         m_status = content.as<FrameworkElement>().FindName(L"Status").as<TextBlock>();
-
-        return 0;
     }
 
     LRESULT Size(WORD dx, WORD dy)
@@ -123,38 +499,126 @@ struct XamlHostWindow : public std::enable_shared_from_this<XamlHostWindow>
         return 0;
     }
 
+    // Xaml scales its content, the window takes the suggested size and Size() resizes the island.
+    LRESULT DpiChanged(UINT, const RECT& suggested)
+    {
+        SetWindowPos(m_window.get(), nullptr, suggested.left, suggested.top, suggested.right - suggested.left,
+            suggested.bottom - suggested.top, SWP_NOACTIVATE | SWP_NOZORDER);
+        return 0;
+    }
+
     void Show(int nCmdShow)
     {
-        win32app::create_top_level_window_for_xaml(*this, L"Win32XamlAppWindow", L"Win32 Xaml App");
-        const auto dpi = GetDpiForWindow(m_window.get());
-        const int dx = (600 * dpi) / 96;
-        const int dy = (800 * dpi) / 96;
-        SetWindowPos(m_window.get(), nullptr, 0, 0, dx, dy, SWP_NOACTIVATE | SWP_NOMOVE | SWP_NOZORDER | SWP_SHOWWINDOW);
+        win32app::create_top_level_window_for_xaml(*this, c_windowClassName, L"Win32 Xaml App");
+        const win32app::dpi_context dpi{GetDpiForWindow(m_window.get())};
+        SetWindowPos(m_window.get(), nullptr, 0, 0, dpi.scale(600), dpi.scale(800), SWP_NOACTIVATE | SWP_NOMOVE | SWP_NOZORDER | SWP_SHOWWINDOW);
 
         AddWeakRef(this);
         m_selfRef = shared_from_this();
         m_appRefHolder.emplace(m_appThreadsWaiter.take_reference());
+        m_shutdownToken = s_shutdownTracker.track("XamlHostWindow", GetCurrentThreadId());
     }
 
     LRESULT Destroy()
     {
         RemoveWeakRef(this);
+        m_cancellation.cancel(); // background work for this window is skipped
+        if (m_threadSlot)
+        {
+            RemoveWindowSubclass(m_window.get(), TimeMessagesSubclassProc, 0);
+            RemoveWindowSubclass(m_xamlSourceWindow, TimeMessagesSubclassProc, 0);
+        }
 
         // Close the DesktopWindowXamlSource and the WindowsXamlManager.  This will start Xaml's run down since all the
         // DWXS/WXM on the thread will now be closed.  Xaml's run-down is async, so we need to keep the message loop running.
         m_xamlSource.Close();
         m_xamlManager.Close();
 
-        [](auto that) -> winrt::fire_and_forget {
+        [](auto that, auto rundownToken) -> winrt::fire_and_forget {
             auto delayedRelease = std::move(that->m_selfRef);
-            co_await that->m_queueController.ShutdownQueueAsync();
-        }(this);
+            if (that->m_threadSlot)
+            {
+                // The queue is shared with the other windows of the pool thread, let the rundown run before releasing.
+                that->m_threadSlot.reset();
+                co_await wil::resume_foreground(that->DispatcherQueue(), winrt::Windows::System::DispatcherQueuePriority::Low);
+            }
+            else
+            {
+                co_await that->m_queueController.ShutdownQueueAsync();
+            }
+        }(this, s_shutdownTracker.track("XamlHostWindow rundown", GetCurrentThreadId()));
 
         m_appRefHolder.reset();
+        m_shutdownToken.reset();
 
         return 0;
     }
 
+    // Shared by all windows for CPU heavy work, see OffloadAsync.
+    static win32app::work_stealing_pool& BackgroundPool()
+    {
+        static win32app::work_stealing_pool s_pool;
+        return s_pool;
+    }
+
+    // Cancelled when the window is destroyed, for work started on behalf of the window.
+    win32app::cancellation_token CancellationToken() const
+    {
+        return m_cancellation.token();
+    }
+
+    // Runs work() on the background pool and then then(window, result) on the window's thread, or
+    // then(window) if work returns void. Neither runs if the window is destroyed first, then does not
+    // run if the window's queue no longer accepts work. Exceptions thrown by work or then are logged.
+    // The window is only held on its own thread, so the last reference is never released on the pool.
+    //
+    //    window.OffloadAsync([path] { return LoadFile(path); }, [](auto& window, auto&& text) { window.Show(text); });
+    template <typename Work, typename Then>
+    winrt::fire_and_forget OffloadAsync(Work work, Then then)
+    {
+        // Only these are used on the pool, this must not be touched until it is locked on the window's thread.
+        std::weak_ptr<XamlHostWindow> weakThis = weak_from_this();
+        auto queue = DispatcherQueue();
+        auto token = CancellationToken();
+        auto operation = s_shutdownTracker.track("XamlHostWindow::OffloadAsync", GetCurrentThreadId());
+
+        const bool notCancelled = co_await BackgroundPool().schedule(token);
+        if (!notCancelled)
+        {
+            co_return;
+        }
+
+        try
+        {
+            // winrt::resume_foreground returns false, without resuming on the queue, if the queue is shut down.
+            if constexpr (std::is_void_v<std::invoke_result_t<Work>>)
+            {
+                work();
+                if (token.is_cancelled() || !co_await winrt::resume_foreground(queue) || token.is_cancelled())
+                {
+                    co_return;
+                }
+                if (auto strongThis = weakThis.lock())
+                {
+                    then(*strongThis);
+                }
+            }
+            else
+            {
+                auto result = work();
+                if (token.is_cancelled() || !co_await winrt::resume_foreground(queue) || token.is_cancelled())
+                {
+                    co_return;
+                }
+                if (auto strongThis = weakThis.lock())
+                {
+                    then(*strongThis, std::move(result));
+                }
+            }
+        }
+        CATCH_LOG();
+    }
+
     winrt::Windows::System::DispatcherQueue DispatcherQueue() const
     {
         return m_queueController.DispatcherQueue();
@@ -170,21 +634,27 @@ struct XamlHostWindow : public std::enable_shared_from_this<XamlHostWindow>
         m_xamlSource.Content(newContent);
     }
 
+    // Uses the thread started by Prewarm, if there is one that has not been used.
     template <typename Lambda>
     static winrt::fire_and_forget StartThreadAsync(Lambda fn)
     {
-        auto queueController = winrt::Windows::System::DispatcherQueueController::CreateOnDedicatedThread();
+        auto warm = XamlPrewarmedThread::Take();
+        auto queueController = warm ? std::move(warm->queueController) : winrt::Windows::System::DispatcherQueueController::CreateOnDedicatedThread();
         co_await wil::resume_foreground(queueController.DispatcherQueue());
         fn(std::move(queueController));
+        // The window holds its own WindowsXamlManager now, release the one that kept Xaml initialized.
+        warm.reset();
     }
 
+    // Does not wait for windows being added or removed, the windows are those present in the most recently
+    // published snapshot, see snapshot_registry.h.
     static std::vector<std::shared_ptr<XamlHostWindow>> GetAppWindows()
     {
         std::vector<std::shared_ptr<XamlHostWindow>> result;
 
-        auto lock = std::lock_guard<std::mutex>(m_appWindowLock);
-        result.reserve(m_appWindows.size());
-        for (auto& weakWindow : m_appWindows)
+        auto snapshot = m_appWindows.snapshot();
+        result.reserve(snapshot->size());
+        for (auto& weakWindow : *snapshot)
         {
             if (auto strong = weakWindow.lock())
             {
@@ -197,18 +667,83 @@ struct XamlHostWindow : public std::enable_shared_from_this<XamlHostWindow>
     template <typename Lambda>
     winrt::Windows::Foundation::IAsyncAction RunAsync(Lambda fn)
     {
+        // For pool hosted windows report the queue depth and handler time used to place new windows.
+        std::optional<win32app::ui_thread_placement::work_item> work;
+        if (m_threadSlot)
+        {
+            work.emplace(m_threadSlot->queue_work());
+        }
         co_await wil::resume_foreground(DispatcherQueue());
+        if (work)
+        {
+            work->start();
+        }
         fn(*this);
     }
 
+    // Runs fn on every window's thread at the same time, completing when all of them are done.
+    // Each window gets its own copy of fn and they run concurrently.
     template <typename Lambda>
     static winrt::Windows::Foundation::IAsyncAction BroadcastAsync(Lambda fn)
     {
         auto windows = GetAppWindows();
+
+        std::vector<winrt::Windows::Foundation::IAsyncAction> operations;
+        operations.reserve(windows.size());
         for (const auto& windowRef : windows)
         {
-            co_await wil::resume_foreground(windowRef.get()->DispatcherQueue());
-            fn(*windowRef.get());
+            operations.emplace_back(windowRef->RunAsync(fn)); // starts immediately
+        }
+        for (const auto& operation : operations)
+        {
+            co_await operation;
+        }
+    }
+
+    // A window that had not finished the broadcast when the timeout expired. elapsed is the time fn took if it
+    // completed after the timeout, before onSlow was called, and empty if it is still running.
+    struct SlowWindow
+    {
+        std::shared_ptr<XamlHostWindow> window;
+        std::optional<std::chrono::steady_clock::duration> elapsed;
+    };
+
+    // Like BroadcastAsync(fn) but stops waiting after timeout. The windows that have not finished are passed
+    // to onSlow, as std::vector<SlowWindow>, they still run fn later. onSlow runs on the caller's context.
+    template <typename Lambda, typename SlowLambda>
+    static winrt::Windows::Foundation::IAsyncAction BroadcastAsync(Lambda fn, winrt::Windows::Foundation::TimeSpan timeout, SlowLambda onSlow)
+    {
+        winrt::apartment_context caller;
+        auto windows = GetAppWindows();
+
+        wil::shared_event allComplete;
+        allComplete.create(wil::EventOptions::ManualReset);
+        auto join = std::make_shared<win32app::fan_out_join>(windows.size(), [allComplete]() {
+            allComplete.SetEvent();
+        });
+
+        for (size_t i = 0; i < windows.size(); i++)
+        {
+            // The handler keeps the window alive until fn has run, which may be after this returns.
+            windows[i]->RunAsync(fn).Completed([join, i, window = windows[i]](auto&&, auto&&) {
+                join->complete(i);
+            });
+        }
+
+        const bool complete = co_await winrt::resume_on_signal(allComplete.get(), timeout);
+        co_await caller; // resume_on_signal continues on a thread pool thread
+        if (!complete)
+        {
+            std::vector<SlowWindow> slowWindows;
+            for (size_t i = 0; i < windows.size(); i++)
+            {
+                const auto elapsed = join->elapsed(i);
+                if (!elapsed || (*elapsed > timeout))
+                {
+                    slowWindows.push_back({windows[i], elapsed});
+                }
+            }
+            onSlow(slowWindows);
         }
     }
 
@@ -222,22 +757,38 @@ struct XamlHostWindow : public std::enable_shared_from_this<XamlHostWindow>
         m_appThreadsWaiter.wait_until_zero();
     }
 
+    template <typename Rep, typename Period>
+    static bool wait_until_zero_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        return m_appThreadsWaiter.wait_until_zero_for(timeout);
+    }
+
+    // Windows, their rundown and OffloadAsync operations are tracked by name so a shutdown that does
+    // not finish can report what is outstanding, see shutdown_tracker.h.
+    static win32app::shutdown_tracker& ShutdownTracker()
+    {
+        return s_shutdownTracker;
+    }
+
+    // Waits up to timeout for the tracked operations, an alternative to wait_until_zero() that reports
+    // the stragglers and the shutdown latency.
+    template <typename Rep, typename Period>
+    static win32app::shutdown_report WaitForShutdown(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        return s_shutdownTracker.wait_for(timeout);
+    }
+
     static void AddWeakRef(XamlHostWindow* that)
     {
-        auto lock = std::lock_guard<std::mutex>(m_appWindowLock);
-        XamlHostWindow::m_appWindows.emplace_back(that->weak_from_this());
+        that->m_appWindowsSlot = m_appWindows.add(that->weak_from_this());
     }
 
     static void RemoveWeakRef(XamlHostWindow* that)
     {
-        auto lock = std::lock_guard<std::mutex>(m_appWindowLock);
-        m_appWindows.erase(std::find_if(m_appWindows.begin(), m_appWindows.end(), [&](auto&& weakOther) {
-            if (auto strong = weakOther.lock())
-            {
-                return strong.get() == that;
-            }
-            return false;
-        }));
+        if (auto slot = std::exchange(that->m_appWindowsSlot, std::nullopt))
+        {
+            m_appWindows.remove(*slot);
+        }
     }
 
     wil::unique_hwnd m_window;
@@ -247,6 +798,10 @@ private:
 
     std::shared_ptr<XamlHostWindow> m_selfRef;                                    // needed to extend lifetime during async rundown
     std::optional<reference_waiter::reference_waiter_holder> m_appRefHolder; // need to ensure lifetime of the app process
+    std::optional<win32app::snapshot_registry<std::weak_ptr<XamlHostWindow>>::handle> m_appWindowsSlot; // this window in m_appWindows, set from Show to Destroy
+    std::optional<win32app::ui_thread_placement::window_slot> m_threadSlot; // set when hosted by XamlWindowThreadPool
+    win32app::cancellation_source m_cancellation; // cancelled in Destroy, see OffloadAsync
+    win32app::shutdown_tracker::operation_token m_shutdownToken; // from Show to Destroy
 
     // This is needed to coordinate the use of Xaml from multiple threads.
     winrt::Windows::UI::Xaml::Hosting::WindowsXamlManager m_xamlManager{nullptr};
@@ -254,7 +809,32 @@ private:
     winrt::Windows::UI::Xaml::Hosting::DesktopWindowXamlSource m_xamlSource{nullptr};
     winrt::Windows::UI::Xaml::Controls::TextBlock m_status{nullptr};
 
+    static constexpr PCWSTR c_windowClassName = L"Win32XamlAppWindow";
+
+    // Records the time pool hosted windows spend handling messages, see XamlWindowThreadPool. Messages sent
+    // while another is handled on the thread are part of the outer message's time.
+    static LRESULT CALLBACK TimeMessagesSubclassProc(HWND window, UINT message, WPARAM wparam, LPARAM lparam, UINT_PTR, DWORD_PTR data) noexcept
+    {
+        if (t_messageDepth != 0)
+        {
+            return DefSubclassProc(window, message, wparam, lparam);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        t_messageDepth++;
+        const auto result = DefSubclassProc(window, message, wparam, lparam);
+        t_messageDepth--;
+        if (auto that = reinterpret_cast<XamlHostWindow*>(data); that->m_threadSlot) // reset when the window is destroyed
+        {
+            that->m_threadSlot->record_handler_time(std::chrono::steady_clock::now() - start);
+        }
+        return result;
+    }
+
+    inline static thread_local uint32_t t_messageDepth{}; // see TimeMessagesSubclassProc
+    inline static std::once_flag s_prewarmOnce;
+    inline static std::atomic<const win32app::embedded_resource_table*> s_embeddedResources{}; // read by the window and prewarm threads
     inline static reference_waiter m_appThreadsWaiter;
-    inline static std::mutex m_appWindowLock;
-    inline static std::vector<std::weak_ptr<XamlHostWindow>> m_appWindows;
+    inline static win32app::shutdown_tracker s_shutdownTracker;
+    inline static win32app::snapshot_registry<std::weak_ptr<XamlHostWindow>> m_appWindows;
 };
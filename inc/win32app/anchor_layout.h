@@ -0,0 +1,178 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "layout_rect.h"
+
+// anchor_layout
+//
+// The layout computation behind ResizeableDialog.h, separated from the windows it moves. Controls are
+// anchored to the edges of their parent's client area, an edge a control is anchored to keeps its
+// distance to that edge of the client area, see ANCHOR_FLAGS.
+//
+// Offsets are recorded in the encoding InitResizeData has always used, per axis:
+//   anchored to both edges    near = distance from the near edge, far = distance from the far edge (negative)
+//   anchored to the far edge  near = size of the control, far = distance from the far edge
+//   otherwise                 near and far are the position of the control, it does not move
+// where near is left or top and far is right or bottom.
+//
+// anchor_layout keeps the offsets as a structure of arrays, so the layout of each axis is a simple
+// loop over arrays of integers, and the last rects so only the controls that changed are reported.
+//
+//    win32app::anchor_layout layout;
+//    layout.add(edges, controlRect, clientRect);  // for each control
+//    for (auto index : layout.update(newClientRect)) { move(index, layout.rect(index)); }
+//
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+// The values of ANCHOR_FLAGS.
+enum anchor_edges : uint8_t
+{
+    anchor_none = 0x00,
+    anchor_left = 0x01,
+    anchor_right = 0x02,
+    anchor_top = 0x04,
+    anchor_bottom = 0x08,
+};
+
+namespace details
+{
+    struct axis_extent
+    {
+        int32_t start;
+        int32_t end;
+    };
+
+    constexpr axis_extent anchor_axis_offsets(bool toNear, bool toFar, int32_t controlNear, int32_t controlFar, int32_t clientNear, int32_t clientFar)
+    {
+        if (toNear && toFar)
+        {
+            return {controlNear - clientNear, controlFar - clientFar};
+        }
+        if (toFar)
+        {
+            return {controlFar - controlNear, controlFar - clientFar};
+        }
+        return {controlNear, controlFar};
+    }
+
+    constexpr axis_extent anchor_axis(bool toNear, bool toFar, int32_t offsetNear, int32_t offsetFar, int32_t clientNear, int32_t clientFar)
+    {
+        const int32_t end = toFar ? clientFar + offsetFar : offsetFar;
+        const int32_t start = toFar ? (toNear ? clientNear + offsetNear : end - offsetNear) : offsetNear;
+        return {start, end};
+    }
+} // namespace details
+
+// The offsets InitResizeData records for a control at rect in the client area client.
+constexpr layout_rect anchor_offsets(uint8_t edges, const layout_rect& rect, const layout_rect& client)
+{
+    const auto x = details::anchor_axis_offsets(edges & anchor_left, edges & anchor_right, rect.left, rect.right, client.left, client.right);
+    const auto y = details::anchor_axis_offsets(edges & anchor_top, edges & anchor_bottom, rect.top, rect.bottom, client.top, client.bottom);
+    return {x.start, y.start, x.end, y.end};
+}
+
+// The rect of a control with the given offsets in the client area client.
+constexpr layout_rect anchor_rect(uint8_t edges, const layout_rect& offsets, const layout_rect& client)
+{
+    const auto x = details::anchor_axis(edges & anchor_left, edges & anchor_right, offsets.left, offsets.right, client.left, client.right);
+    const auto y = details::anchor_axis(edges & anchor_top, edges & anchor_bottom, offsets.top, offsets.bottom, client.top, client.bottom);
+    return {x.start, y.start, x.end, y.end};
+}
+
+// The rect of the control at current after the client area changed to client, as the RECT array form of OnSize
+// has always computed it: only the edges that follow the far edge of the client area are replaced, the far edge
+// and, for a control anchored only to the far edge, the near edge. The others stay where they are, so a control
+// the app moved after InitResizeData keeps that position on the axes it is not anchored to the far edge.
+constexpr layout_rect anchor_far_edges(uint8_t edges, const layout_rect& offsets, const layout_rect& client, const layout_rect& current)
+{
+    const auto anchored = anchor_rect(edges, offsets, client);
+    auto rect = current;
+    if (edges & anchor_right)
+    {
+        rect.right = anchored.right;
+        rect.left = (edges & anchor_left) ? current.left : anchored.left;
+    }
+    if (edges & anchor_bottom)
+    {
+        rect.bottom = anchored.bottom;
+        rect.top = (edges & anchor_top) ? current.top : anchored.top;
+    }
+    return rect;
+}
+
+struct anchor_layout
+{
+    // rect is the position of the control in the client area client, normally the one from the dialog template.
+    void add(uint8_t edges, const layout_rect& rect, const layout_rect& client)
+    {
+        const auto offsets = anchor_offsets(edges, rect, client);
+        m_edges.push_back(edges);
+        m_offsetLeft.push_back(offsets.left);
+        m_offsetTop.push_back(offsets.top);
+        m_offsetRight.push_back(offsets.right);
+        m_offsetBottom.push_back(offsets.bottom);
+        m_current.push_back(rect);
+    }
+
+    size_t size() const
+    {
+        return m_edges.size();
+    }
+
+    // Pure, the rects of all the controls for the client area client. result must have size() elements.
+    // One pass per axis, each is a loop without branches over the offset arrays.
+    void compute(const layout_rect& client, std::span<layout_rect> result) const
+    {
+        for (size_t i = 0; i < m_edges.size(); i++)
+        {
+            const auto x = details::anchor_axis(m_edges[i] & anchor_left, m_edges[i] & anchor_right, m_offsetLeft[i], m_offsetRight[i], client.left, client.right);
+            result[i].left = x.start;
+            result[i].right = x.end;
+        }
+        for (size_t i = 0; i < m_edges.size(); i++)
+        {
+            const auto y = details::anchor_axis(m_edges[i] & anchor_top, m_edges[i] & anchor_bottom, m_offsetTop[i], m_offsetBottom[i], client.top, client.bottom);
+            result[i].top = y.start;
+            result[i].bottom = y.end;
+        }
+    }
+
+    // Lays out the controls for client and returns the indexes of the controls whose rect changed, rect(index)
+    // is the new rect. The result is valid until the next call.
+    std::span<const uint32_t> update(const layout_rect& client)
+    {
+        m_next.resize(size());
+        compute(client, m_next);
+        m_changed.clear();
+        for (size_t i = 0; i < m_next.size(); i++)
+        {
+            if (m_next[i] != m_current[i])
+            {
+                m_current[i] = m_next[i];
+                m_changed.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        return m_changed;
+    }
+
+    // The rect of a control as of the last update, or its initial rect.
+    const layout_rect& rect(size_t index) const
+    {
+        return m_current[index];
+    }
+
+private:
+    std::vector<uint8_t> m_edges;
+    std::vector<int32_t> m_offsetLeft;
+    std::vector<int32_t> m_offsetTop;
+    std::vector<int32_t> m_offsetRight;
+    std::vector<int32_t> m_offsetBottom;
+    std::vector<layout_rect> m_current;
+    std::vector<layout_rect> m_next;
+    std::vector<uint32_t> m_changed;
+};
+} // namespace win32app
@@ -0,0 +1,274 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compressed resources
+//
+// Large RCDATA payloads (XAML, JSON, localization tables) can be stored compressed to reduce
+// binary size and the bytes paged in at startup. A compressed resource starts with a small
+// header that identifies the codec and the decompressed size, followed by the compressed data.
+// Resources without the header are used as is, so compression can be adopted one resource at a time.
+//
+//    offset  size  content
+//    0       4     'W' '3' '2' 'Z'
+//    4       1     codec, see compression_codec
+//    5       3     reserved, 0
+//    8       4     decompressed size in bytes, little endian
+//    12      ...   compressed data
+//
+// Tools/compress_resource.cpp produces these, get_decompressed_resource_view() in utf8_helpers.h
+// reads them. The LZ4 block format is implemented here to avoid a dependency, zstd is reserved
+// but not supported.
+//
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+enum class compression_codec : uint8_t
+{
+    stored = 0,
+    lz4_block = 1,
+    zstd = 2, // reserved
+};
+
+struct compressed_resource_header
+{
+    compression_codec codec;
+    uint32_t decompressed_size;
+    std::string_view payload;
+};
+
+constexpr size_t c_compressedResourceHeaderSize = 12;
+constexpr char c_compressedResourceMagic[4]{'W', '3', '2', 'Z'};
+
+namespace details
+{
+    inline uint32_t read_le32(const unsigned char* bytes) noexcept
+    {
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    }
+} // namespace details
+
+// Returns nothing if the content does not start with the compressed resource header.
+inline std::optional<compressed_resource_header> parse_compressed_resource_header(std::string_view content) noexcept
+{
+    if ((content.size() < c_compressedResourceHeaderSize) || (memcmp(content.data(), c_compressedResourceMagic, sizeof(c_compressedResourceMagic)) != 0))
+    {
+        return std::nullopt;
+    }
+    const auto bytes = reinterpret_cast<const unsigned char*>(content.data());
+    return compressed_resource_header{
+        static_cast<compression_codec>(bytes[4]), details::read_le32(bytes + 8), content.substr(c_compressedResourceHeaderSize)};
+}
+
+// Decodes an LZ4 block (not the LZ4 frame format) into exactly destinationSize bytes.
+// Returns false for malformed or truncated input, never reads or writes out of bounds.
+inline bool lz4_decompress_block(std::string_view source, unsigned char* destination, size_t destinationSize) noexcept
+{
+    const auto input = reinterpret_cast<const unsigned char*>(source.data());
+    const size_t inputSize = source.size();
+    size_t in = 0, out = 0;
+
+    auto readLength = [&](size_t& length) {
+        unsigned char next;
+        do
+        {
+            if (in >= inputSize)
+            {
+                return false;
+            }
+            next = input[in++];
+            length += next;
+        } while (next == 255);
+        return true;
+    };
+
+    while (in < inputSize)
+    {
+        const unsigned char token = input[in++];
+
+        size_t literalLength = token >> 4;
+        if ((literalLength == 15) && !readLength(literalLength))
+        {
+            return false;
+        }
+        if ((literalLength > inputSize - in) || (literalLength > destinationSize - out))
+        {
+            return false;
+        }
+        if (literalLength != 0) // destination may be null when destinationSize is 0
+        {
+            memcpy(destination + out, input + in, literalLength);
+        }
+        in += literalLength;
+        out += literalLength;
+
+        if (in == inputSize)
+        {
+            break; // the last sequence has only literals
+        }
+
+        if (inputSize - in < 2)
+        {
+            return false;
+        }
+        const size_t offset = input[in] | (input[in + 1] << 8);
+        in += 2;
+        if ((offset == 0) || (offset > out))
+        {
+            return false;
+        }
+
+        size_t matchLength = token & 0x0F;
+        if ((matchLength == 15) && !readLength(matchLength))
+        {
+            return false;
+        }
+        matchLength += 4; // minimum match
+        if (matchLength > destinationSize - out)
+        {
+            return false;
+        }
+
+        // The match may overlap the output being written (offset < length), copy forward one byte at a time.
+        for (size_t i = 0; i < matchLength; i++, out++)
+        {
+            destination[out] = destination[out - offset];
+        }
+    }
+    return out == destinationSize;
+}
+
+// Greedy LZ4 block compressor, intended for build time tools. The output is decodable by any LZ4 implementation.
+inline std::string lz4_compress_block(std::string_view source)
+{
+    constexpr size_t minMatch = 4;
+    constexpr size_t lastLiterals = 5;  // the last 5 bytes are always literals
+    constexpr size_t matchFindLimit = 12; // a match can't start within the last 12 bytes
+    constexpr size_t maxOffset = 65535;
+    constexpr int hashBits = 14;
+
+    const auto input = reinterpret_cast<const unsigned char*>(source.data());
+    const size_t inputSize = source.size();
+
+    std::string result;
+    result.reserve(inputSize + (inputSize / 255) + 16);
+
+    auto writeLength = [&](size_t length) {
+        for (; length >= 255; length -= 255)
+        {
+            result.push_back(static_cast<char>(255));
+        }
+        result.push_back(static_cast<char>(length));
+    };
+
+    auto writeSequence = [&](size_t literalStart, size_t literalLength, size_t offset, size_t matchLength) {
+        const size_t matchCode = (matchLength != 0) ? matchLength - minMatch : 0;
+        result.push_back(static_cast<char>(((literalLength < 15 ? literalLength : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+        if (literalLength >= 15)
+        {
+            writeLength(literalLength - 15);
+        }
+        result.append(source.substr(literalStart, literalLength));
+        if (matchLength != 0)
+        {
+            result.push_back(static_cast<char>(offset & 0xFF));
+            result.push_back(static_cast<char>(offset >> 8));
+            if (matchCode >= 15)
+            {
+                writeLength(matchCode - 15);
+            }
+        }
+    };
+
+    size_t anchor = 0;
+    if (inputSize > matchFindLimit)
+    {
+        std::vector<uint32_t> table(size_t{1} << hashBits); // position + 1 of the last occurrence, 0 for none
+        auto read32 = [&](size_t position) {
+            uint32_t value;
+            memcpy(&value, input + position, sizeof(value));
+            return value;
+        };
+
+        const size_t matchStartLimit = inputSize - matchFindLimit;
+        const size_t matchEndLimit = inputSize - lastLiterals;
+        size_t position = 0;
+        while (position < matchStartLimit)
+        {
+            const auto sequence = read32(position);
+            auto& slot = table[(sequence * 2654435761u) >> (32 - hashBits)];
+            const size_t candidate = slot;
+            slot = static_cast<uint32_t>(position + 1);
+
+            if ((candidate != 0) && (position - (candidate - 1) <= maxOffset) && (read32(candidate - 1) == sequence))
+            {
+                const size_t match = candidate - 1;
+                size_t length = minMatch;
+                while ((position + length < matchEndLimit) && (input[match + length] == input[position + length]))
+                {
+                    length++;
+                }
+                writeSequence(anchor, position - anchor, position - match, length);
+                position += length;
+                anchor = position;
+            }
+            else
+            {
+                position++;
+            }
+        }
+    }
+    writeSequence(anchor, inputSize - anchor, 0, 0);
+    return result;
+}
+
+// Returns the content with the compressed resource header, using LZ4 when that makes it smaller.
+inline std::string make_compressed_resource(std::string_view content)
+{
+    auto compressed = lz4_compress_block(content);
+    const bool useCompressed = compressed.size() < content.size();
+    const auto size = static_cast<uint32_t>(content.size());
+
+    std::string result(c_compressedResourceMagic, sizeof(c_compressedResourceMagic));
+    result.push_back(static_cast<char>(useCompressed ? compression_codec::lz4_block : compression_codec::stored));
+    result.append(3, '\0');
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        result.push_back(static_cast<char>((size >> shift) & 0xFF));
+    }
+    result.append(useCompressed ? std::string_view{compressed} : content);
+    return result;
+}
+
+// Returns nothing if the codec is not supported or the payload is malformed.
+inline std::optional<std::string> decompress_resource(const compressed_resource_header& header)
+{
+    switch (header.codec)
+    {
+    case compression_codec::stored:
+        if (header.payload.size() != header.decompressed_size)
+        {
+            return std::nullopt;
+        }
+        return std::string{header.payload};
+
+    case compression_codec::lz4_block:
+        if (std::string result(header.decompressed_size, '\0'); !lz4_decompress_block(header.payload, reinterpret_cast<unsigned char*>(result.data()), result.size()))
+        {
+            return std::nullopt;
+        }
+        else
+        {
+            return result;
+        }
+
+    default:
+        return std::nullopt;
+    }
+}
+} // namespace win32app
@@ -0,0 +1,207 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "anchor_layout.h"
+
+// constraint_layout
+//
+// A richer layout description than the ANCHOR_FLAGS of ResizeableDialog.h, for split panes,
+// proportional columns, minimum and maximum sizes and DPI changes, without writing WM_SIZE code.
+//
+// Each edge of a control follows a point of the client area given in per-mille of its width or
+// height: 0 is the left (top) edge, 1000 the right (bottom) edge and 500 the middle. The distance from
+// that point is recorded from the control's initial position, like InitResizeData records anchors, and
+// is scaled when the DPI changes. Edge anchors are the ratios 0 and 1000, see from_anchor().
+//
+// Minimum and maximum sizes are in 96 DPI units (0 for none). When a size is clamped the left (top)
+// edge stays in place, unless the control follows only the right (bottom) edge, then that one does.
+//
+// Tables are built at compile time, stack_constraints() and grid_constraints() generate the ratios
+// for controls that share a row, a column or a grid equally. Recording and layout are constexpr and
+// do not allocate.
+//
+//    static constexpr auto c_columns = win32app::stack_constraints<2>(win32app::stack_orientation::horizontal);
+//    win32app::constraint_table<2> table{c_columns};
+//    table.record(initialRects, initialClient, dpi);
+//    auto rects = table.compute(client, dpi);
+//
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct layout_constraint
+{
+    static constexpr uint16_t c_near = 0;
+    static constexpr uint16_t c_far = 1000;
+
+    uint16_t left = c_near; // per-mille of the client width
+    uint16_t top = c_near;  // per-mille of the client height
+    uint16_t right = c_near;
+    uint16_t bottom = c_near;
+    int32_t minWidth = 0; // 96 DPI units, 0 for no limit
+    int32_t minHeight = 0;
+    int32_t maxWidth = 0;
+    int32_t maxHeight = 0;
+
+    constexpr layout_constraint with_min_size(int32_t width, int32_t height) const
+    {
+        auto result = *this;
+        result.minWidth = width;
+        result.minHeight = height;
+        return result;
+    }
+
+    constexpr layout_constraint with_max_size(int32_t width, int32_t height) const
+    {
+        auto result = *this;
+        result.maxWidth = width;
+        result.maxHeight = height;
+        return result;
+    }
+};
+
+// The constraint equivalent to an ANCHOR_FLAGS value.
+constexpr layout_constraint from_anchor(uint8_t edges)
+{
+    constexpr auto axis = [](bool toNear, bool toFar) -> std::array<uint16_t, 2> {
+        if (toFar)
+        {
+            return {toNear ? layout_constraint::c_near : layout_constraint::c_far, layout_constraint::c_far};
+        }
+        return {layout_constraint::c_near, layout_constraint::c_near};
+    };
+    const auto x = axis(edges & anchor_left, edges & anchor_right);
+    const auto y = axis(edges & anchor_top, edges & anchor_bottom);
+    return {x[0], y[0], x[1], y[1]};
+}
+
+constexpr layout_constraint proportional(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom)
+{
+    return {left, top, right, bottom};
+}
+
+enum class stack_orientation
+{
+    horizontal, // a row, the controls share the width
+    vertical,   // a column, the controls share the height
+};
+
+// Rows * Columns controls sharing the client area equally, in row major order.
+template <size_t Rows, size_t Columns>
+constexpr std::array<layout_constraint, Rows * Columns> grid_constraints()
+{
+    static_assert((Rows > 0) && (Columns > 0));
+    std::array<layout_constraint, Rows * Columns> result{};
+    for (size_t row = 0; row < Rows; row++)
+    {
+        for (size_t column = 0; column < Columns; column++)
+        {
+            result[row * Columns + column] = proportional(static_cast<uint16_t>(column * 1000 / Columns), static_cast<uint16_t>(row * 1000 / Rows),
+                static_cast<uint16_t>((column + 1) * 1000 / Columns), static_cast<uint16_t>((row + 1) * 1000 / Rows));
+        }
+    }
+    return result;
+}
+
+template <size_t Count>
+constexpr std::array<layout_constraint, Count> stack_constraints(stack_orientation orientation)
+{
+    return (orientation == stack_orientation::horizontal) ? grid_constraints<1, Count>() : grid_constraints<Count, 1>();
+}
+
+namespace details
+{
+    constexpr int32_t c_defaultDpi = 96;
+
+    // value * numerator / denominator rounded to nearest, like MulDiv.
+    constexpr int32_t mul_div(int32_t value, int32_t numerator, int32_t denominator)
+    {
+        const int64_t product = int64_t{value} * numerator;
+        const int64_t half = denominator / 2;
+        return static_cast<int32_t>((product >= 0) ? (product + half) / denominator : (product - half) / denominator);
+    }
+
+    constexpr int32_t ratio_point(uint16_t ratio, int32_t clientNear, int32_t clientFar)
+    {
+        return clientNear + static_cast<int32_t>((int64_t{clientFar - clientNear} * ratio) / 1000);
+    }
+
+    constexpr void clamp_extent(int32_t& low, int32_t& high, int32_t minSize, int32_t maxSize, bool keepHigh)
+    {
+        auto size = high - low;
+        if ((minSize > 0) && (size < minSize))
+        {
+            size = minSize;
+        }
+        if ((maxSize > 0) && (size > maxSize))
+        {
+            size = maxSize;
+        }
+        if (keepHigh)
+        {
+            low = high - size;
+        }
+        else
+        {
+            high = low + size;
+        }
+    }
+} // namespace details
+
+template <size_t Count>
+struct constraint_table
+{
+    std::array<layout_constraint, Count> constraints{};
+    std::array<layout_rect, Count> offsets{}; // distance of each edge from the point it follows, at recordedDpi
+    int32_t recordedDpi = details::c_defaultDpi;
+
+    // Records the offsets from the initial positions of the controls.
+    constexpr void record(std::span<const layout_rect, Count> rects, const layout_rect& client, int32_t dpi = details::c_defaultDpi)
+    {
+        recordedDpi = dpi;
+        for (size_t i = 0; i < Count; i++)
+        {
+            const auto& constraint = constraints[i];
+            offsets[i] = {rects[i].left - details::ratio_point(constraint.left, client.left, client.right),
+                          rects[i].top - details::ratio_point(constraint.top, client.top, client.bottom),
+                          rects[i].right - details::ratio_point(constraint.right, client.left, client.right),
+                          rects[i].bottom - details::ratio_point(constraint.bottom, client.top, client.bottom)};
+        }
+    }
+
+    constexpr layout_rect compute(size_t index, const layout_rect& client, int32_t dpi = details::c_defaultDpi) const
+    {
+        const auto& constraint = constraints[index];
+        const auto& offset = offsets[index];
+        const auto scale = [&](int32_t value) {
+            return (dpi == recordedDpi) ? value : details::mul_div(value, dpi, recordedDpi);
+        };
+        const auto scaleLimit = [&](int32_t value) {
+            return details::mul_div(value, dpi, details::c_defaultDpi);
+        };
+
+        layout_rect result{details::ratio_point(constraint.left, client.left, client.right) + scale(offset.left),
+                           details::ratio_point(constraint.top, client.top, client.bottom) + scale(offset.top),
+                           details::ratio_point(constraint.right, client.left, client.right) + scale(offset.right),
+                           details::ratio_point(constraint.bottom, client.top, client.bottom) + scale(offset.bottom)};
+
+        details::clamp_extent(result.left, result.right, scaleLimit(constraint.minWidth), scaleLimit(constraint.maxWidth),
+            constraint.left == layout_constraint::c_far);
+        details::clamp_extent(result.top, result.bottom, scaleLimit(constraint.minHeight), scaleLimit(constraint.maxHeight),
+            constraint.top == layout_constraint::c_far);
+        return result;
+    }
+
+    constexpr std::array<layout_rect, Count> compute(const layout_rect& client, int32_t dpi = details::c_defaultDpi) const
+    {
+        std::array<layout_rect, Count> result{};
+        for (size_t i = 0; i < Count; i++)
+        {
+            result[i] = compute(i, client, dpi);
+        }
+        return result;
+    }
+};
+} // namespace win32app
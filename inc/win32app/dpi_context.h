@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// dpi_context
+//
+// The DPI of a window and the values scaled for it. dpi_context scales 96 DPI (view pixel) values
+// to the window's DPI, rounding like MulDiv. dpi_resources keeps objects built for a DPI, fonts,
+// brushes and metrics, so they are created once rather than on every paint, and drops them only when
+// the DPI changes.
+//
+//    struct PaintResources
+//    {
+//        explicit PaintResources(const win32app::dpi_context& dpi) : font(L"Segoe UI", dpi.scale(12.0f)) {}
+//        Gdiplus::Font font;
+//    };
+//    win32app::dpi_resources<PaintResources> m_paint;
+//
+//    Show            m_paint.set_dpi(GetDpiForWindow(m_window.get()));
+//    Paint           const auto& resources = m_paint.get();   // created on first use for the current DPI
+//    DpiChanged      m_paint.set_dpi(dpi);                    // the resources are recreated on next use
+//
+// The window's DPI comes from the WM_DPICHANGED handler, DpiChanged(dpi, suggestedRect), see
+// win32_app_helpers.h.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+constexpr uint32_t c_defaultDpi = 96;
+
+// value * dpi / 96 rounded to nearest, like MulDiv.
+constexpr int32_t scale_for_dpi(int32_t value, uint32_t dpi)
+{
+    const int64_t product = int64_t{value} * dpi;
+    const int64_t half = c_defaultDpi / 2;
+    return static_cast<int32_t>((product >= 0) ? (product + half) / c_defaultDpi : (product - half) / c_defaultDpi);
+}
+
+constexpr float scale_for_dpi(float value, uint32_t dpi)
+{
+    return (value * static_cast<float>(dpi)) / static_cast<float>(c_defaultDpi);
+}
+
+struct dpi_context
+{
+    uint32_t dpi = c_defaultDpi;
+
+    constexpr int32_t scale(int32_t value) const
+    {
+        return scale_for_dpi(value, dpi);
+    }
+
+    constexpr float scale(float value) const
+    {
+        return scale_for_dpi(value, dpi);
+    }
+
+    // Back to 96 DPI units.
+    constexpr int32_t unscale(int32_t value) const
+    {
+        const int64_t product = int64_t{value} * c_defaultDpi;
+        const int64_t half = dpi / 2;
+        return static_cast<int32_t>((product >= 0) ? (product + half) / dpi : (product - half) / dpi);
+    }
+};
+
+// TResources is constructed from a dpi_context, it does not need to be copyable or movable.
+// Used by the window's thread.
+template <typename TResources>
+struct dpi_resources
+{
+    const dpi_context& context() const
+    {
+        return m_context;
+    }
+
+    uint32_t dpi() const
+    {
+        return m_context.dpi;
+    }
+
+    // Returns true if the DPI changed, the resources are then recreated on next use.
+    bool set_dpi(uint32_t dpi)
+    {
+        if (dpi == m_context.dpi)
+        {
+            return false;
+        }
+        m_context.dpi = dpi;
+        m_resources.reset();
+        return true;
+    }
+
+    const TResources& get()
+    {
+        if (!m_resources)
+        {
+            m_resources.emplace(m_context);
+            m_creations++;
+        }
+        return *m_resources;
+    }
+
+    // Drops the resources, for example when the system font changes.
+    void reset()
+    {
+        m_resources.reset();
+    }
+
+    // The number of times the resources were created, to check they are not recreated needlessly.
+    size_t creations() const
+    {
+        return m_creations;
+    }
+
+private:
+    dpi_context m_context;
+    std::optional<TResources> m_resources;
+    size_t m_creations{};
+};
+} // namespace win32app
@@ -0,0 +1,63 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+
+// embedded_resource_table
+//
+// Access to UTF-16 text produced at build time by Tools/embed_utf16_resources.cpp. The generated
+// header holds all of the resources packed into one constexpr array plus an index of name, offset
+// and length sorted by name. Lookups return views into that array, no conversion or allocation
+// happens at runtime.
+//
+//    #include "AppResources.g.h" // generated, defines app_resources::c_table
+//
+//    auto xaml = win32app::get_embedded_resource_view(app_resources::c_table, L"AppWindow.xaml");
+//
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct embedded_resource
+{
+    std::wstring_view name;
+    uint32_t offset; // in characters, into embedded_resource_table::data
+    uint32_t length; // in characters, the content is also null terminated
+};
+
+struct embedded_resource_table
+{
+    const embedded_resource* index;
+    size_t count;
+    const wchar_t* data;
+
+    constexpr const embedded_resource* begin() const
+    {
+        return index;
+    }
+
+    constexpr const embedded_resource* end() const
+    {
+        return index + count;
+    }
+
+    // Returns an empty view if the name is not present, like get_resource_view().
+    constexpr std::wstring_view find(std::wstring_view name) const
+    {
+        auto it = std::lower_bound(begin(), end(), name, [](const embedded_resource& entry, std::wstring_view value) {
+            return entry.name < value;
+        });
+        if ((it != end()) && (it->name == name))
+        {
+            return {data + it->offset, it->length};
+        }
+        return {};
+    }
+};
+
+// Same shape as get_resource_view<wchar_t>(name) for content that was pre-transcoded at build time.
+constexpr std::basic_string_view<wchar_t> get_embedded_resource_view(const embedded_resource_table& table, std::wstring_view name)
+{
+    return table.find(name);
+}
+} // namespace win32app
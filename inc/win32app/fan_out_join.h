@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// fan_out_join
+//
+// Join state for a set of operations started at the same time, for example a broadcast to every
+// window thread. Each operation reports completion by index, the owner either waits (optionally
+// bounded by a timeout) or is called back when the last one completes. Operations that have not
+// completed when the owner stops waiting are reported by pending(), with their start relative
+// completion times available from elapsed().
+//
+//    auto join = std::make_shared<win32app::fan_out_join>(targets.size());
+//    for (size_t i = 0; i < targets.size(); i++)
+//    {
+//        targets[i].post([join, i] { work(); join->complete(i); });
+//    }
+//    if (!join->wait_for(100ms)) { report(join->pending()); }
+//
+// Completion can happen after the owner stops waiting, hold the join in a shared_ptr.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct fan_out_join
+{
+    using clock = std::chrono::steady_clock;
+
+    // onAllComplete runs on the thread that completes the last operation, immediately if count is 0.
+    explicit fan_out_join(size_t count, std::function<void()> onAllComplete = {}) :
+        m_remaining(count), m_completions(count), m_onAllComplete(std::move(onAllComplete))
+    {
+        if ((count == 0) && m_onAllComplete)
+        {
+            m_onAllComplete();
+        }
+    }
+
+    fan_out_join(const fan_out_join&) = delete;
+    fan_out_join& operator=(const fan_out_join&) = delete;
+
+    // Call once per index.
+    void complete(size_t index)
+    {
+        m_completions[index].store((clock::now() - m_start).count(), std::memory_order_release);
+        if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_cv.notify_all();
+            }
+            if (m_onAllComplete)
+            {
+                m_onAllComplete();
+            }
+        }
+    }
+
+    bool is_complete() const
+    {
+        return m_remaining.load(std::memory_order_acquire) == 0;
+    }
+
+    // Returns false if some operations did not complete before the timeout.
+    template <typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        return m_cv.wait_for(lock, timeout, [&] { return is_complete(); });
+    }
+
+    // The indexes of the operations that have not completed yet.
+    std::vector<size_t> pending() const
+    {
+        std::vector<size_t> result;
+        for (size_t i = 0; i < m_completions.size(); i++)
+        {
+            if (m_completions[i].load(std::memory_order_acquire) == c_notCompleted)
+            {
+                result.push_back(i);
+            }
+        }
+        return result;
+    }
+
+    // Time from the start of the fan out to the completion of an operation, nothing if it has not completed.
+    std::optional<clock::duration> elapsed(size_t index) const
+    {
+        const auto ticks = m_completions[index].load(std::memory_order_acquire);
+        if (ticks == c_notCompleted)
+        {
+            return std::nullopt;
+        }
+        return clock::duration{ticks};
+    }
+
+private:
+    static constexpr clock::rep c_notCompleted = -1;
+
+    struct completion : std::atomic<clock::rep>
+    {
+        completion() : std::atomic<clock::rep>(c_notCompleted)
+        {
+        }
+    };
+
+    const clock::time_point m_start{clock::now()};
+    std::atomic<size_t> m_remaining;
+    std::vector<completion> m_completions;
+    std::function<void()> m_onAllComplete;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+};
+} // namespace win32app
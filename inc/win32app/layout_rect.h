@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+// layout_rect
+//
+// A rect in integer coordinates, left and top inclusive, right and bottom exclusive like the Win32 RECT,
+// shared by the layout headers and window_snapshot.h so the window headers do not depend on the layout ones.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct layout_rect
+{
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+
+    constexpr bool operator==(const layout_rect&) const = default;
+};
+} // namespace win32app
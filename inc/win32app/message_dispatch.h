@@ -0,0 +1,283 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+
+#if defined(WIN32APP_ENABLE_TRACING)
+#include "startup_trace.h"
+#elif !defined(WIN32APP_TRACE_SCOPE)
+// Tracing is off, the trace points compile to nothing without startup_trace.h, see there.
+#define WIN32APP_TRACE_SCOPE(name) \
+    do \
+    { \
+    } while (0)
+#define WIN32APP_TRACE_THREAD_NAME(name) \
+    do \
+    { \
+    } while (0)
+#endif
+
+// message_dispatch
+//
+// The window message dispatch of the windows created by create_top_level_window (win32_app_helpers.h),
+// which includes this header. It uses the Win32 types and WM_ values, LOWORD and HIWORD, and BeginPaint,
+// EndPaint and DefWindowProcW, include it after <windows.h>. Tools/win32_shim.h defines that subset so the
+// dispatch can be built and benchmarked on other platforms.
+
+namespace win32app
+{
+// Window Message dispatch implementation
+// Each message maps to a function prototype that can handle it. Clients implement the function of
+// the given name and parameter list and messages will get dispatched to them.
+//
+// The 'wparam' and 'lparam' are converted into message specific values and passed to the function.
+// Conversions are to the Win32 primitive representation to enable the most flexibility.
+//
+// message_traits is the registration point, a specialization detects the handler and decodes the
+// parameters for it. The built in messages below only detect it, HandleMessage decodes them in its switch.
+// Messages beyond those are added without changing this header:
+//
+//    template <>
+//    struct win32app::message_traits<WM_TIMER>
+//    {
+//        template <typename T>
+//        static constexpr bool is_handled_by = requires(T& window) { window.Timer(UINT_PTR{}); };
+//
+//        template <typename T>
+//        static LRESULT dispatch(T& window, WPARAM wparam, LPARAM) { return window.Timer(static_cast<UINT_PTR>(wparam)); }
+//    };
+//
+// and the window class lists them, the messages defined here need not be listed:
+//
+//    using messages = win32app::message_list<WM_TIMER>;
+//
+// A HandleMessage(UINT32, WPARAM, LPARAM) member receives the messages no other handler took, except the
+// built in ones above, those go to DefWindowProcW when the class has no handler for them.
+template <unsigned int Message>
+struct message_traits
+{
+    using unregistered = void; // only the primary template, a message listed without a specialization does not compile
+
+    template <typename T>
+    static constexpr bool is_handled_by = false;
+};
+
+template <unsigned int... Messages>
+struct message_list
+{
+};
+
+// The value message_traits uses for HandleMessage(UINT32, WPARAM, LPARAM).
+constexpr unsigned int c_anyMessage = ~0u;
+
+template <typename T, unsigned int Message>
+concept handles_message = message_traits<Message>::template is_handled_by<T>;
+
+template <>
+struct message_traits<WM_MOVE>
+{
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.Move(std::declval<unsigned short>(), std::declval<unsigned short>()); };
+};
+
+template <>
+struct message_traits<WM_SIZE>
+{
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.Size(std::declval<unsigned short>(), std::declval<unsigned short>()); };
+};
+
+template <>
+struct message_traits<WM_CREATE>
+{
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.Create(); };
+};
+
+template <>
+struct message_traits<WM_DESTROY>
+{
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.Destroy(); };
+};
+
+template <>
+struct message_traits<WM_PAINT>
+{
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.Paint(std::declval<HDC>(), std::declval<const PAINTSTRUCT&>()); };
+};
+
+template <>
+struct message_traits<WM_COMMAND>
+{
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.Command(std::declval<unsigned short>()); };
+};
+
+template <>
+struct message_traits<WM_DEVICECHANGE>
+{
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.DeviceChange(std::declval<unsigned int>(), std::declval<void*>()); };
+};
+
+template <>
+struct message_traits<WM_DPICHANGED>
+{
+    // The new DPI and the window rect suggested for it, normally applied with SetWindowPos.
+    template <typename T>
+    static constexpr bool is_handled_by = requires(T& window) { window.DpiChanged(std::declval<unsigned int>(), std::declval<const RECT&>()); };
+};
+
+template <>
+struct message_traits<c_anyMessage>
+{
+    template <typename T>
+    static constexpr bool is_handled_by =
+        requires(T& window) { window.HandleMessage(std::declval<UINT32>(), std::declval<WPARAM>(), std::declval<LPARAM>()); };
+};
+
+namespace details
+{
+    // msg<WM_SIZE, T>::is_valid is true if T handles WM_SIZE.
+    template <unsigned int value_, typename T>
+    struct msg
+    {
+        static constexpr unsigned int value = value_;
+        static constexpr bool is_valid = handles_message<T, value_>;
+    };
+
+    template <typename T>
+    struct class_messages
+    {
+        using type = message_list<>;
+    };
+
+    template <typename T>
+        requires requires { typename T::messages; }
+    struct class_messages<T>
+    {
+        using type = typename T::messages;
+    };
+
+    template <unsigned int... Left, unsigned int... Right>
+    constexpr message_list<Left..., Right...> operator+(message_list<Left...>, message_list<Right...>)
+    {
+        return {};
+    }
+
+    template <unsigned int... Messages>
+    constexpr bool is_registered(message_list<Messages...>)
+    {
+        return (!requires { typename message_traits<Messages>::unregistered; } && ...);
+    }
+
+    // The messages of the list that T has a handler for. This is computed on types only, so code is
+    // generated for the handled messages and not for every message a class could handle.
+    template <typename T, unsigned int... Messages>
+    constexpr auto handled_messages(message_list<Messages...>)
+    {
+        return (message_list<>{} + ... + std::conditional_t<handles_message<T, Messages>, message_list<Messages>, message_list<>>{});
+    }
+
+    template <typename T, unsigned int... Messages>
+    bool dispatch_messages(message_list<Messages...>, T* that, UINT32 message, WPARAM wparam, LPARAM lparam, LRESULT& result)
+    {
+        return (((message == Messages) && ((result = message_traits<Messages>::dispatch(*that, wparam, lparam)), true)) || ...);
+    }
+
+    // The built in messages are decoded in the switch and the listed ones through their message_traits,
+    // so a class gets one function for its dispatch, plus one per listed message it handles.
+    template <typename T>
+    LRESULT HandleMessage(T* that, UINT32 message, WPARAM wparam, LPARAM lparam)
+    {
+        using listed = typename class_messages<T>::type;
+        static_assert(is_registered(listed{}),
+            "A message in the class's message_list has no message_traits specialization, its handler would never be called.");
+        switch (message)
+        {
+        case WM_MOVE:
+            if constexpr (handles_message<T, WM_MOVE>)
+            {
+                return that->Move(LOWORD(lparam), HIWORD(lparam));
+            }
+            break;
+
+        case WM_SIZE:
+            if constexpr (handles_message<T, WM_SIZE>)
+            {
+                return that->Size(LOWORD(lparam), HIWORD(lparam));
+            }
+            break;
+
+        case WM_CREATE:
+            if constexpr (handles_message<T, WM_CREATE>)
+            {
+                return that->Create();
+            }
+            break;
+
+        case WM_DESTROY:
+            if constexpr (handles_message<T, WM_DESTROY>)
+            {
+                return that->Destroy();
+            }
+            break;
+
+        case WM_PAINT:
+            if constexpr (handles_message<T, WM_PAINT>)
+            {
+                WIN32APP_TRACE_SCOPE("WM_PAINT");
+                PAINTSTRUCT ps{};
+                auto hdc{BeginPaint(that->m_window.get(), &ps)};
+                auto result = that->Paint(hdc, ps);
+                EndPaint(that->m_window.get(), &ps);
+                return result;
+            }
+            break;
+
+        case WM_COMMAND:
+            if constexpr (handles_message<T, WM_COMMAND>)
+            {
+                return that->Command(LOWORD(wparam));
+            }
+            break;
+
+        case WM_DEVICECHANGE:
+            if constexpr (handles_message<T, WM_DEVICECHANGE>)
+            {
+                return that->DeviceChange(static_cast<UINT>(wparam), reinterpret_cast<void*>(lparam));
+            }
+            break;
+
+        case WM_DPICHANGED:
+            if constexpr (handles_message<T, WM_DPICHANGED>)
+            {
+                return that->DpiChanged(HIWORD(wparam), *reinterpret_cast<const RECT*>(lparam));
+            }
+            break;
+
+        default:
+        {
+            using handled = decltype(handled_messages<T>(listed{}));
+            if constexpr (!std::is_same_v<handled, message_list<>>)
+            {
+                LRESULT result{};
+                if (dispatch_messages(handled{}, that, message, wparam, lparam, result))
+                {
+                    return result;
+                }
+            }
+            // Built in messages without a handler go to DefWindowProcW as they always have, a catch all that
+            // returns 0 for the messages it does not know would otherwise leave WM_PAINT unvalidated.
+            if constexpr (handles_message<T, c_anyMessage>)
+            {
+                return that->HandleMessage(message, wparam, lparam);
+            }
+        }
+        break;
+        }
+        return DefWindowProcW(that->m_window.get(), message, wparam, lparam);
+    }
+} // namespace details
+} // namespace win32app
@@ -0,0 +1,279 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// message_trace
+//
+// Records the messages windows receive, with their parameters and the time they arrived, so a stream
+// of real user input can be replayed against a window's handlers to measure them. Recording is opt-in,
+// see win32app::start_message_recording() in win32_app_helpers.h, the window procedure of the windows
+// created by create_top_level_window pays one relaxed atomic load per message when it is off.
+//
+//    auto records = win32app::stop_message_recording();
+//    std::ofstream file("input.w32m", std::ios::binary);
+//    win32app::write_message_trace(file, records);
+//
+//    auto trace = win32app::read_message_trace(content);   // nothing if the content is not a trace
+//    auto report = win32app::replay_messages(*trace, [&](const win32app::message_record& record) {
+//        dispatch(record.message, record.wparam, record.lparam);
+//    }, win32app::replay_speed::real_time);
+//
+// The report has the time spent per message. Parameters that point to memory (WM_CREATE, WM_NOTIFY...)
+// are recorded as numbers and are not valid on replay, replay_message_trace() in win32_app_helpers.h
+// only replays the messages whose parameters are values, see is_replayable_message().
+//
+// Format, little endian: the 8 byte header "W32M", version (uint16), record size (uint16), followed by
+// records of time (int64 ns from the start of the recording), window (uint64), wparam (uint64),
+// lparam (int64) and message (uint32).
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct message_record
+{
+    int64_t time_ns; // since the recording started
+    uint64_t window;
+    uint64_t wparam;
+    int64_t lparam;
+    uint32_t message;
+
+    bool operator==(const message_record&) const = default;
+};
+
+constexpr char c_messageTraceMagic[4]{'W', '3', '2', 'M'};
+constexpr uint16_t c_messageTraceVersion = 1;
+constexpr size_t c_messageTraceHeaderSize = 8;
+constexpr size_t c_messageRecordSize = 36;
+
+// Thread safe, windows on different threads can record into the same recorder. Records past capacity are
+// counted and dropped.
+struct message_recorder
+{
+    using clock = std::chrono::steady_clock;
+
+    explicit message_recorder(size_t capacity = 1024 * 1024) : m_capacity(capacity)
+    {
+        m_records.reserve(std::min<size_t>(capacity, 64 * 1024));
+    }
+
+    // Called from window procedures, it does not throw. A record that can not be stored is counted as dropped.
+    void record(uint64_t window, uint32_t message, uint64_t wparam, int64_t lparam) noexcept
+    {
+        const auto now = clock::now();
+        try
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_records.size() < m_capacity)
+            {
+                m_records.push_back({std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count(), window, wparam, lparam, message});
+                return;
+            }
+        }
+        catch (...)
+        {
+            // out of memory growing the records, or the lock failed
+        }
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<message_record> take()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return std::exchange(m_records, {});
+    }
+
+    // Discards the records and restarts the time.
+    void restart()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_records.clear();
+        m_dropped.store(0, std::memory_order_relaxed);
+        m_start = clock::now();
+    }
+
+    size_t dropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    const size_t m_capacity;
+    mutable std::mutex m_lock;
+    clock::time_point m_start{clock::now()};
+    std::vector<message_record> m_records;
+    std::atomic<size_t> m_dropped{};
+};
+
+// The messages whose parameters are values and that only report input or a change, so replaying them runs the
+// handlers without side effects outside the window: mouse and keyboard input, WM_SIZE, WM_MOVE and WM_COMMAND.
+// The rest are not replayed, their parameters may point to memory (WM_SIZING, WM_DRAWITEM, WM_SETTINGCHANGE) or to
+// code (WM_TIMER with a TIMERPROC), or default handling acts on the window (WM_SYSCOMMAND with SC_CLOSE, Alt+F4 as
+// WM_SYSKEYDOWN, non-client clicks). The values are those of the Win32 WM_ messages.
+constexpr bool is_replayable_message(uint32_t message)
+{
+    switch (message)
+    {
+    case 0x0003: // WM_MOVE
+    case 0x0005: // WM_SIZE
+    case 0x0100: // WM_KEYDOWN
+    case 0x0101: // WM_KEYUP
+    case 0x0102: // WM_CHAR
+    case 0x0103: // WM_DEADCHAR
+    case 0x0111: // WM_COMMAND
+    case 0x02A1: // WM_MOUSEHOVER
+    case 0x02A3: // WM_MOUSELEAVE
+        return true;
+    }
+    return (message >= 0x0200) && (message <= 0x020E); // WM_MOUSEFIRST to WM_MOUSELAST, client area mouse input
+}
+
+namespace details
+{
+    template <typename T>
+    void append_le(std::string& out, T value)
+    {
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            out.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (i * 8)) & 0xFF));
+        }
+    }
+
+    template <typename T>
+    T read_le(const unsigned char* bytes)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            value |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+        }
+        return static_cast<T>(value);
+    }
+} // namespace details
+
+inline std::string make_message_trace(std::span<const message_record> records)
+{
+    std::string result;
+    result.reserve(c_messageTraceHeaderSize + records.size() * c_messageRecordSize);
+    result.append(c_messageTraceMagic, sizeof(c_messageTraceMagic));
+    details::append_le(result, c_messageTraceVersion);
+    details::append_le(result, static_cast<uint16_t>(c_messageRecordSize));
+    for (const auto& record : records)
+    {
+        details::append_le(result, record.time_ns);
+        details::append_le(result, record.window);
+        details::append_le(result, record.wparam);
+        details::append_le(result, record.lparam);
+        details::append_le(result, record.message);
+    }
+    return result;
+}
+
+template <typename TStream>
+void write_message_trace(TStream& out, std::span<const message_record> records)
+{
+    const auto trace = make_message_trace(records);
+    out.write(trace.data(), static_cast<std::streamsize>(trace.size()));
+}
+
+// Returns nothing if content is not a trace of a supported version. Newer versions may have longer
+// records, the fields known to this version are read.
+inline std::optional<std::vector<message_record>> read_message_trace(std::string_view content)
+{
+    if ((content.size() < c_messageTraceHeaderSize) || (memcmp(content.data(), c_messageTraceMagic, sizeof(c_messageTraceMagic)) != 0))
+    {
+        return std::nullopt;
+    }
+    const auto bytes = reinterpret_cast<const unsigned char*>(content.data());
+    const auto version = details::read_le<uint16_t>(bytes + 4);
+    const auto recordSize = details::read_le<uint16_t>(bytes + 6);
+    if ((version < c_messageTraceVersion) || (recordSize < c_messageRecordSize) || (((content.size() - c_messageTraceHeaderSize) % recordSize) != 0))
+    {
+        return std::nullopt;
+    }
+
+    std::vector<message_record> records((content.size() - c_messageTraceHeaderSize) / recordSize);
+    auto in = bytes + c_messageTraceHeaderSize;
+    for (auto& record : records)
+    {
+        record.time_ns = details::read_le<int64_t>(in);
+        record.window = details::read_le<uint64_t>(in + 8);
+        record.wparam = details::read_le<uint64_t>(in + 16);
+        record.lparam = details::read_le<int64_t>(in + 24);
+        record.message = details::read_le<uint32_t>(in + 32);
+        in += recordSize;
+    }
+    return records;
+}
+
+enum class replay_speed
+{
+    full_speed, // back to back, measures the handlers
+    real_time,  // with the recorded spacing, reproduces timing dependent behavior
+};
+
+struct message_timing
+{
+    uint32_t message;
+    size_t count;
+    std::chrono::nanoseconds total;
+    std::chrono::nanoseconds max;
+};
+
+struct replay_report
+{
+    std::vector<message_timing> messages; // sorted by total time, most expensive first
+    size_t replayed;
+    std::chrono::nanoseconds handler_time; // the sum of the handler times
+    std::chrono::nanoseconds elapsed;      // including the waits when replaying in real time
+};
+
+// Calls dispatch(record) for each record, timing each call.
+template <typename TDispatch>
+replay_report replay_messages(std::span<const message_record> records, TDispatch&& dispatch, replay_speed speed = replay_speed::full_speed)
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<message_timing> timings;
+    replay_report report{};
+    const auto start = clock::now();
+    const auto firstTime = records.empty() ? 0 : records.front().time_ns;
+    for (const auto& record : records)
+    {
+        if (speed == replay_speed::real_time)
+        {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(record.time_ns - firstTime));
+        }
+
+        const auto callStart = clock::now();
+        dispatch(record);
+        const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - callStart);
+
+        auto timing = std::find_if(timings.begin(), timings.end(), [&](const auto& entry) { return entry.message == record.message; });
+        if (timing == timings.end())
+        {
+            timing = timings.insert(timings.end(), {record.message, 0, {}, {}});
+        }
+        timing->count++;
+        timing->total += duration;
+        timing->max = std::max<std::chrono::nanoseconds>(timing->max, duration);
+        report.handler_time += duration;
+        report.replayed++;
+    }
+    report.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+
+    std::sort(timings.begin(), timings.end(), [](const auto& left, const auto& right) { return left.total > right.total; });
+    report.messages = std::move(timings);
+    return report;
+}
+} // namespace win32app
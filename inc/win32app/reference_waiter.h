@@ -1,7 +1,12 @@
 #pragma once
-#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 /*
 reference_waiter
@@ -52,56 +57,281 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR lpCmdLine, int nCmdS
 }
 */
 
+// The count is a single atomic, taking and releasing a reference is one atomic operation. Waiters are
+// only woken when the count transitions to zero. The last release notifies after the count reaches
+// zero, so the reference_waiter should outlive the holders, normally it is a static.
+//
+// wait_until_zero_for() bounds the wait, for shutdown paths that must not hang.
+// co_await waiter.when_zero() suspends a coroutine until the count reaches zero. It is resumed inline,
+// on the thread that released the last reference and inside the destructor of its holder, keep the code
+// that follows short or switch threads first, for example with co_await winrt::resume_background().
 struct reference_waiter
 {
     void wait_until_zero()
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_cv.wait(lock, [&] { return m_count == 0; });
+        for (auto count = m_count.load(); count != 0; count = m_count.load())
+        {
+            m_count.wait(count);
+        }
+    }
+
+    // Returns false if the count did not reach zero before the timeout.
+    template <typename Rep, typename Period>
+    bool wait_until_zero_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        if (m_count.load() == 0)
+        {
+            return true;
+        }
+
+        m_slowWaiters.fetch_add(1);
+        std::unique_lock<std::mutex> lock(m_lock);
+        const auto result = m_cv.wait_for(lock, timeout, [&] { return m_count.load() == 0; });
+        lock.unlock();
+        m_slowWaiters.fetch_sub(1);
+        return result;
+    }
+
+    struct zero_awaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return m_s.m_count.load() == 0;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            m_s.m_slowWaiters.fetch_add(1);
+            std::lock_guard<std::mutex> lock(m_s.m_lock);
+            if (m_s.m_count.load() == 0)
+            {
+                m_s.m_slowWaiters.fetch_sub(1);
+                return false; // reached zero while registering, continue without suspending
+            }
+            m_s.m_awaiters.push_back(handle);
+            return true;
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+
+        reference_waiter& m_s;
+    };
+
+    [[nodiscard]] zero_awaiter when_zero()
+    {
+        return {*this};
     }
 
     struct reference_waiter_holder
     {
-        reference_waiter_holder(reference_waiter& s) : m_s(s)
+        reference_waiter_holder(reference_waiter& s) : m_s(&s)
         {
-            add();
+            m_s->m_count.fetch_add(1, std::memory_order_relaxed);
         }
 
         ~reference_waiter_holder()
         {
-            subtract();
+            reset();
         }
 
         reference_waiter_holder() = delete;
         reference_waiter_holder(const reference_waiter_holder&) = delete;
         const reference_waiter_holder& operator=(const reference_waiter_holder&) = delete;
 
-        reference_waiter_holder(reference_waiter_holder&& other) noexcept : m_s(other.m_s)
+        // Moves transfer the reference, the moved from holder no longer holds one.
+        reference_waiter_holder(reference_waiter_holder&& other) noexcept : m_s(std::exchange(other.m_s, nullptr))
         {
-            add();
         }
-        reference_waiter_holder& operator=(reference_waiter_holder&&) noexcept
+
+        reference_waiter_holder& operator=(reference_waiter_holder&& other) noexcept
         {
-            add();
+            if (this != &other)
+            {
+                reset();
+                m_s = std::exchange(other.m_s, nullptr);
+            }
             return *this;
         }
 
     private:
-        void add()
+        void reset()
+        {
+            if (auto s = std::exchange(m_s, nullptr))
+            {
+                if (s->m_count.fetch_sub(1) == 1)
+                {
+                    s->m_count.notify_all(); // notify the waiting thread(s), only on the transition to zero
+                    if (s->m_slowWaiters.load() != 0)
+                    {
+                        s->notify_slow_waiters();
+                    }
+                }
+            }
+        }
+
+        reference_waiter* m_s;
+    };
+
+    [[nodiscard]] reference_waiter_holder take_reference()
+    {
+        return reference_waiter_holder(*this);
+    }
+
+private:
+    // Timed waits and coroutines need the lock, it is only taken when one of them is present.
+    void notify_slow_waiters()
+    {
+        std::vector<std::coroutine_handle<>> awaiters;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            awaiters.swap(m_awaiters);
+            m_cv.notify_all();
+        }
+        for (auto& awaiter : awaiters)
         {
-            std::unique_lock<std::mutex> lock(m_s.m_mutex);
-            m_s.m_count++;
-            m_s.m_cv.notify_all(); // notify the waiting thread
+            m_slowWaiters.fetch_sub(1);
+            awaiter.resume();
         }
+    }
 
-        void subtract()
+    std::atomic<int> m_count{0};
+    std::atomic<int> m_slowWaiters{0};
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::vector<std::coroutine_handle<>> m_awaiters;
+};
+
+// sharded_reference_waiter
+//
+// Variant of reference_waiter for very high take/release rates from many threads. The count is
+// split over cache line sized shards selected by the calling thread so references taken on different
+// threads don't contend. A reference is released to the shard it was taken from. The shards are only
+// combined when a thread is waiting, releases check for that with one extra load.
+// The waits are those of reference_waiter, when_zero() resumes the coroutine the same way.
+template <size_t ShardCount = 32>
+struct sharded_reference_waiter
+{
+    void wait_until_zero()
+    {
+        m_waiters.fetch_add(1);
+        for (;;)
         {
-            std::unique_lock<std::mutex> lock(m_s.m_mutex);
-            m_s.m_count--;
-            m_s.m_cv.notify_all(); // notify the waiting thread
+            const auto epoch = m_epoch.load();
+            if (is_zero())
+            {
+                break;
+            }
+            m_epoch.wait(epoch); // woken when any shard reaches zero
         }
+        m_waiters.fetch_sub(1);
+    }
 
-        reference_waiter& m_s;
+    // Returns false if the count did not reach zero before the timeout.
+    template <typename Rep, typename Period>
+    bool wait_until_zero_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        if (is_zero())
+        {
+            return true;
+        }
+
+        m_slowWaiters.fetch_add(1);
+        std::unique_lock<std::mutex> lock(m_lock);
+        const auto result = m_cv.wait_for(lock, timeout, [&] { return is_zero(); });
+        lock.unlock();
+        m_slowWaiters.fetch_sub(1);
+        return result;
+    }
+
+    struct zero_awaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return m_s.is_zero();
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            m_s.m_slowWaiters.fetch_add(1);
+            std::lock_guard<std::mutex> lock(m_s.m_lock);
+            if (m_s.is_zero())
+            {
+                m_s.m_slowWaiters.fetch_sub(1);
+                return false; // reached zero while registering, continue without suspending
+            }
+            m_s.m_awaiters.push_back(handle);
+            return true;
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+
+        sharded_reference_waiter& m_s;
+    };
+
+    [[nodiscard]] zero_awaiter when_zero()
+    {
+        return {*this};
+    }
+
+    struct reference_waiter_holder
+    {
+        reference_waiter_holder(sharded_reference_waiter& s) : m_s(&s), m_shard(&s.m_shards[current_shard_index() % ShardCount])
+        {
+            m_shard->value.fetch_add(c_take, std::memory_order_relaxed);
+        }
+
+        ~reference_waiter_holder()
+        {
+            reset();
+        }
+
+        reference_waiter_holder() = delete;
+        reference_waiter_holder(const reference_waiter_holder&) = delete;
+        const reference_waiter_holder& operator=(const reference_waiter_holder&) = delete;
+
+        reference_waiter_holder(reference_waiter_holder&& other) noexcept :
+            m_s(std::exchange(other.m_s, nullptr)), m_shard(std::exchange(other.m_shard, nullptr))
+        {
+        }
+
+        reference_waiter_holder& operator=(reference_waiter_holder&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                m_s = std::exchange(other.m_s, nullptr);
+                m_shard = std::exchange(other.m_shard, nullptr);
+            }
+            return *this;
+        }
+
+    private:
+        void reset()
+        {
+            if (auto s = std::exchange(m_s, nullptr))
+            {
+                const auto previous = std::exchange(m_shard, nullptr)->value.fetch_add(c_release);
+                if ((previous & c_countMask) == 1)
+                {
+                    if (s->m_waiters.load() != 0)
+                    {
+                        s->m_epoch.fetch_add(1);
+                        s->m_epoch.notify_all();
+                    }
+                    if (s->m_slowWaiters.load() != 0)
+                    {
+                        s->notify_slow_waiters();
+                    }
+                }
+            }
+        }
+
+        sharded_reference_waiter* m_s;
+        typename sharded_reference_waiter::shard* m_shard;
     };
 
     [[nodiscard]] reference_waiter_holder take_reference()
@@ -110,7 +340,70 @@ struct reference_waiter
     }
 
 private:
-    std::mutex m_mutex;
+    // Each shard packs the count in the low 32 bits and a count of changes in the high 32 bits, which lets
+    // is_zero() detect changes made while it reads the shards.
+    static constexpr uint64_t c_countMask = 0xFFFFFFFF;
+    static constexpr uint64_t c_take = (uint64_t{1} << 32) + 1;
+    static constexpr uint64_t c_release = (uint64_t{1} << 32) - 1;
+
+    struct alignas(64) shard
+    {
+        std::atomic<uint64_t> value{0};
+    };
+
+    static size_t current_shard_index()
+    {
+        static std::atomic<size_t> s_nextIndex{0};
+        thread_local const size_t t_index = s_nextIndex.fetch_add(1, std::memory_order_relaxed);
+        return t_index;
+    }
+
+    // Two passes, the shards are all zero at one point in time if none of them changed between the passes.
+    bool is_zero() const
+    {
+        uint64_t values[ShardCount];
+        for (size_t i = 0; i < ShardCount; i++)
+        {
+            values[i] = m_shards[i].value.load();
+            if ((values[i] & c_countMask) != 0)
+            {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < ShardCount; i++)
+        {
+            if (m_shards[i].value.load() != values[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // A shard reached zero, the timed waits check the total, the coroutines are resumed if it is zero.
+    void notify_slow_waiters()
+    {
+        std::vector<std::coroutine_handle<>> awaiters;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (is_zero())
+            {
+                awaiters.swap(m_awaiters);
+            }
+            m_cv.notify_all();
+        }
+        for (auto& awaiter : awaiters)
+        {
+            m_slowWaiters.fetch_sub(1);
+            awaiter.resume();
+        }
+    }
+
+    shard m_shards[ShardCount];
+    std::atomic<int> m_waiters{0};
+    std::atomic<uint32_t> m_epoch{0};
+    std::atomic<int> m_slowWaiters{0};
+    std::mutex m_lock;
     std::condition_variable m_cv;
-    int m_count = 0;
+    std::vector<std::coroutine_handle<>> m_awaiters;
 };
@@ -0,0 +1,123 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+// resize_throttle
+//
+// Decides when to lay out a window while it is being resized. Outside of an interactive resize every
+// size change is laid out. During one (WM_ENTERSIZEMOVE to WM_EXITSIZEMOVE) layout is limited to once
+// per display frame, size changes in between are deferred and a timer commits the last of them if no
+// other size change arrives, so the window does not stay stale when the drag pauses. When the drag ends
+// one exact layout is done.
+//
+//    win32app::resize_throttle throttle{frameInterval};
+//
+//    WM_ENTERSIZEMOVE  throttle.enter_size_move();
+//    WM_SIZE           auto decision = throttle.size_changed(now);
+//                      if (decision.layout) layout();
+//                      if (decision.arm_timer) start a one shot timer for decision.timer_delay;
+//    WM_TIMER          if (throttle.timer_elapsed(now)) layout();
+//    WM_EXITSIZEMOVE   throttle.exit_size_move(); cancel the timer; layout();
+//
+// Time is passed in so the policy can be driven by simulated resize streams.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct resize_decision
+{
+    bool layout{};    // lay out now
+    bool arm_timer{}; // start the timer, timer_elapsed() should be called after timer_delay
+    std::chrono::steady_clock::duration timer_delay{};
+};
+
+struct resize_throttle
+{
+    using clock = std::chrono::steady_clock;
+
+    static constexpr clock::duration c_defaultFrameInterval = std::chrono::microseconds(16667); // 60Hz
+
+    resize_throttle() = default;
+
+    explicit resize_throttle(clock::duration frameInterval) : m_frameInterval(frameInterval)
+    {
+    }
+
+    void set_frame_interval(clock::duration frameInterval)
+    {
+        m_frameInterval = frameInterval;
+    }
+
+    void enter_size_move()
+    {
+        m_live = true;
+        m_pending = false;
+        m_lastLayout = clock::time_point{};
+    }
+
+    resize_decision size_changed(clock::time_point now)
+    {
+        if (!m_live || ((now - m_lastLayout) >= m_frameInterval))
+        {
+            m_lastLayout = now;
+            m_pending = false;
+            m_layouts++;
+            return {true, false, {}};
+        }
+
+        m_pending = true;
+        m_deferred++;
+        const bool armTimer = !m_timerArmed;
+        m_timerArmed = true;
+        return {false, armTimer, m_frameInterval - (now - m_lastLayout)};
+    }
+
+    // Returns true if a deferred size change should be laid out now. The timer is one shot, it can be cancelled.
+    bool timer_elapsed(clock::time_point now)
+    {
+        m_timerArmed = false;
+        if (!m_pending)
+        {
+            return false;
+        }
+        m_pending = false;
+        m_lastLayout = now;
+        m_layouts++;
+        return true;
+    }
+
+    // The caller lays out after this, exactly, and cancels the timer.
+    void exit_size_move()
+    {
+        m_live = false;
+        m_pending = false;
+        m_timerArmed = false;
+        m_layouts++;
+    }
+
+    bool is_live() const
+    {
+        return m_live;
+    }
+
+    // Counts of layouts done and size changes deferred, for measuring the effect of the throttle.
+    size_t layouts() const
+    {
+        return m_layouts;
+    }
+
+    size_t deferred() const
+    {
+        return m_deferred;
+    }
+
+private:
+    clock::duration m_frameInterval{c_defaultFrameInterval};
+    clock::time_point m_lastLayout{};
+    bool m_live{};
+    bool m_pending{};
+    bool m_timerArmed{};
+    size_t m_layouts{};
+    size_t m_deferred{};
+};
+} // namespace win32app
@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// resource_cache
+//
+// Process wide, thread safe cache of values derived from module resources, keyed by
+// module, name and type. Resources are immutable for the lifetime of a module so the value
+// is computed once, on first use, and then shared. Reads of populated entries are lock free,
+// only the first use of a key takes the lock.
+//
+// This has no dependency on the Windows headers, names and types follow the resource API
+// convention, either a string or an integer identifier produced by MAKEINTRESOURCEW().
+//
+//    inline win32app::resource_cache<std::wstring> s_decoded;
+//
+//    auto& text = s_decoded.get_or_create(module, L"AppWindow.xaml", RT_RCDATA, [&]
+//    {
+//        return from_utf8(skip_utf8_bom(get_resource_view(L"AppWindow.xaml", RT_RCDATA, module)));
+//    });
+//
+// Entries are never removed, do not use this for modules that get unloaded.
+
+namespace win32app
+{
+struct resource_cache_stats
+{
+    uint64_t hits;
+    uint64_t misses;
+};
+
+template <typename TValue>
+struct resource_cache
+{
+    resource_cache() = default;
+    resource_cache(const resource_cache&) = delete;
+    resource_cache& operator=(const resource_cache&) = delete;
+
+    ~resource_cache()
+    {
+        auto entry = m_head.load(std::memory_order_relaxed);
+        while (entry)
+        {
+            delete std::exchange(entry, entry->next);
+        }
+    }
+
+    // TFactory is called at most once per key, while holding the lock, and must return a TValue.
+    template <typename TFactory>
+    const TValue& get_or_create(const void* module, const wchar_t* name, const wchar_t* type, TFactory&& factory)
+    {
+        if (auto found = find(m_head.load(std::memory_order_acquire), module, name, type))
+        {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return found->value;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto head = m_head.load(std::memory_order_acquire);
+        if (auto found = find(head, module, name, type)) // populated by another thread while waiting for the lock
+        {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return found->value;
+        }
+
+        auto entry = new cache_entry{module, name, type, std::forward<TFactory>(factory)(), head};
+        m_head.store(entry, std::memory_order_release);
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return entry->value;
+    }
+
+    resource_cache_stats stats() const
+    {
+        return {m_hits.load(std::memory_order_relaxed), m_misses.load(std::memory_order_relaxed)};
+    }
+
+private:
+    // Resource names and types are either strings or integer identifiers stored in the low word of the pointer.
+    static bool is_int_resource(const wchar_t* value)
+    {
+        return reinterpret_cast<uintptr_t>(value) <= 0xFFFF; // IS_INTRESOURCE()
+    }
+
+    struct resource_name
+    {
+        resource_name(const wchar_t* value) : id(reinterpret_cast<uintptr_t>(value))
+        {
+            if (!is_int_resource(value))
+            {
+                name = value; // copy, the callers buffer may not outlive the cache
+            }
+        }
+
+        // Compare against the callers value without allocating.
+        bool matches(const wchar_t* value) const
+        {
+            return is_int_resource(value) ? (name.empty() && (id == reinterpret_cast<uintptr_t>(value))) : (!name.empty() && (name == value));
+        }
+
+        uintptr_t id{};
+        std::wstring name;
+    };
+
+    struct cache_entry
+    {
+        const void* const module;
+        const resource_name name;
+        const resource_name type;
+        const TValue value;
+        cache_entry* const next;
+    };
+
+    static const cache_entry* find(const cache_entry* entry, const void* module, const wchar_t* name, const wchar_t* type)
+    {
+        for (; entry; entry = entry->next)
+        {
+            if ((entry->module == module) && entry->name.matches(name) && entry->type.matches(type))
+            {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    std::atomic<cache_entry*> m_head{};
+    std::atomic<uint64_t> m_hits{};
+    std::atomic<uint64_t> m_misses{};
+    std::mutex m_lock;
+};
+} // namespace win32app
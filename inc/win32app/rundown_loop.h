@@ -0,0 +1,38 @@
+#pragma once
+#include <chrono>
+
+// rundown_loop
+//
+// The loop that bounds Xaml's rundown in the enter_com_message_loop overload that takes a timeout,
+// see win32_app_helpers.h. It is separate from the Windows calls it makes so it is tested on any
+// platform.
+//
+// dispatch_pending() dispatches the messages that are queued and returns true once it retrieves
+// WM_QUIT, wait(remaining) returns when messages arrive or remaining has passed. The loop returns
+// true when WM_QUIT was retrieved and false if the deadline passed first.
+//
+//    const bool completed = win32app::run_until_quit(std::chrono::steady_clock::now() + 2s, dispatch_pending, wait);
+//
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+template <typename TClock = std::chrono::steady_clock, typename TDispatch, typename TWait>
+bool run_until_quit(typename TClock::time_point deadline, TDispatch&& dispatch_pending, TWait&& wait)
+{
+    for (;;)
+    {
+        if (dispatch_pending())
+        {
+            return true;
+        }
+
+        const auto now = TClock::now();
+        if (now >= deadline)
+        {
+            return false;
+        }
+        wait(std::chrono::ceil<std::chrono::milliseconds>(deadline - now)); // rounded up to not wake before the deadline
+    }
+}
+} // namespace win32app
@@ -0,0 +1,240 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// shutdown_tracker
+//
+// Tracks the operations that must finish before the process can exit, windows and their async
+// rundown for example, by name. Shutdown waits for them with a deadline and when that passes the
+// ones still outstanding (stragglers) are reported with how long they have been running, instead
+// of the process hanging at exit with no indication of why.
+//
+//    inline static win32app::shutdown_tracker s_shutdown;
+//
+//    auto token = s_shutdown.track("window rundown", threadId); // released when the token is destroyed
+//
+//    s_shutdown.begin_shutdown();
+//    auto report = s_shutdown.wait_for(2s);
+//    if (!report.completed) { for (auto& straggler : report.stragglers) { log(straggler.name); } }
+//
+// Names must be string literals or otherwise live as long as the tracker, tracking does not copy them
+// so it does not allocate once the tracker has grown to the number of concurrent operations.
+// Shutdown latency, the time from begin_shutdown() to the release of the last operation, is reported
+// by shutdown_latency() even when nobody waits.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct shutdown_straggler
+{
+    std::string name;
+    uint32_t thread;              // the thread id given to track(), 0 if none
+    std::chrono::nanoseconds age; // time since the operation was tracked
+};
+
+struct shutdown_report
+{
+    bool completed;                  // all operations were released before the deadline
+    std::chrono::nanoseconds waited; // time from begin_shutdown() to completion or the deadline
+    std::vector<shutdown_straggler> stragglers;
+};
+
+struct shutdown_tracker
+{
+    using clock = std::chrono::steady_clock;
+
+    shutdown_tracker() = default;
+    shutdown_tracker(const shutdown_tracker&) = delete;
+    shutdown_tracker& operator=(const shutdown_tracker&) = delete;
+
+    // Releases the operation when destroyed or reset. Moves transfer the operation.
+    struct operation_token
+    {
+        operation_token() = default;
+
+        ~operation_token()
+        {
+            reset();
+        }
+
+        operation_token(const operation_token&) = delete;
+        operation_token& operator=(const operation_token&) = delete;
+
+        operation_token(operation_token&& other) noexcept : m_tracker(std::exchange(other.m_tracker, nullptr)), m_slot(other.m_slot)
+        {
+        }
+
+        operation_token& operator=(operation_token&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                m_tracker = std::exchange(other.m_tracker, nullptr);
+                m_slot = other.m_slot;
+            }
+            return *this;
+        }
+
+        void reset()
+        {
+            if (auto tracker = std::exchange(m_tracker, nullptr))
+            {
+                tracker->release(m_slot);
+            }
+        }
+
+        explicit operator bool() const
+        {
+            return m_tracker != nullptr;
+        }
+
+    private:
+        friend shutdown_tracker;
+
+        operation_token(shutdown_tracker& tracker, size_t slot) : m_tracker(&tracker), m_slot(slot)
+        {
+        }
+
+        shutdown_tracker* m_tracker{};
+        size_t m_slot{};
+    };
+
+    // thread identifies the thread that started the operation in the report, for example GetCurrentThreadId().
+    [[nodiscard]] operation_token track(const char* name, uint32_t thread = 0)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        size_t slot;
+        if (m_freeSlots.empty())
+        {
+            slot = m_operations.size();
+            m_operations.emplace_back();
+        }
+        else
+        {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        m_operations[slot].emplace(operation{name, thread, clock::now()});
+        m_outstanding++;
+        m_shutdownEnd.reset(); // started during shutdown, not done until this one is released
+        return operation_token(*this, slot);
+    }
+
+    size_t outstanding() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_outstanding;
+    }
+
+    // Starts the shutdown latency measurement, later calls have no effect.
+    void begin_shutdown()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_shutdownStart)
+        {
+            m_shutdownStart = clock::now();
+            if (m_outstanding == 0)
+            {
+                m_shutdownEnd = m_shutdownStart;
+            }
+        }
+    }
+
+    bool is_shutting_down() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_shutdownStart.has_value();
+    }
+
+    // Time from begin_shutdown() until no operations were outstanding, nothing if that has not happened yet.
+    std::optional<std::chrono::nanoseconds> shutdown_latency() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_shutdownEnd)
+        {
+            return std::nullopt;
+        }
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(*m_shutdownEnd - *m_shutdownStart);
+    }
+
+    // Calls begin_shutdown() and waits for the outstanding operations, up to timeout.
+    template <typename Rep, typename Period>
+    shutdown_report wait_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        begin_shutdown();
+        std::unique_lock<std::mutex> lock(m_lock);
+        shutdown_report report{};
+        report.completed = m_zero.wait_for(lock, timeout, [&] { return m_outstanding == 0; });
+        const auto end = report.completed ? *m_shutdownEnd : clock::now();
+        report.waited = std::chrono::duration_cast<std::chrono::nanoseconds>(end - *m_shutdownStart);
+        if (!report.completed)
+        {
+            report.stragglers = stragglers_locked(end);
+        }
+        return report;
+    }
+
+    // The outstanding operations, oldest first.
+    std::vector<shutdown_straggler> stragglers() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return stragglers_locked(clock::now());
+    }
+
+private:
+    struct operation
+    {
+        const char* name;
+        uint32_t thread;
+        clock::time_point start;
+    };
+
+    std::vector<shutdown_straggler> stragglers_locked(clock::time_point now) const
+    {
+        std::vector<const operation*> outstanding;
+        for (const auto& entry : m_operations)
+        {
+            if (entry)
+            {
+                outstanding.push_back(&*entry);
+            }
+        }
+        std::stable_sort(outstanding.begin(), outstanding.end(), [](const operation* left, const operation* right) { return left->start < right->start; });
+
+        std::vector<shutdown_straggler> result;
+        result.reserve(outstanding.size());
+        for (const auto entry : outstanding)
+        {
+            result.push_back({entry->name, entry->thread, std::chrono::duration_cast<std::chrono::nanoseconds>(now - entry->start)});
+        }
+        return result;
+    }
+
+    void release(size_t slot)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_operations[slot].reset();
+        m_freeSlots.push_back(slot);
+        if ((--m_outstanding == 0) && m_shutdownStart)
+        {
+            m_shutdownEnd = clock::now();
+            m_zero.notify_all();
+        }
+    }
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_zero;
+    std::vector<std::optional<operation>> m_operations;
+    std::vector<size_t> m_freeSlots;
+    size_t m_outstanding{};
+    std::optional<clock::time_point> m_shutdownStart;
+    std::optional<clock::time_point> m_shutdownEnd;
+};
+} // namespace win32app
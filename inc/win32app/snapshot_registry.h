@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// snapshot_registry
+//
+// A set of values that is read far more often than it is changed, for example the list of open
+// windows used for enumeration and broadcast. Readers get an immutable snapshot and can hold it as
+// long as they like. Writers take a lock, update a slot and publish a new snapshot (copy on write).
+// add() returns a stable slot handle so remove() does not need to search, each handle is removed once.
+//
+// Readers never wait for a writer that is copying the values. They are not lock free,
+// std::atomic<std::shared_ptr> takes a short internal lock with MSVC and libstdc++, held only to copy
+// the pointer and count a reference.
+//
+//    inline static win32app::snapshot_registry<std::weak_ptr<Window>> s_windows;
+//
+//    auto handle = s_windows.add(weak_from_this());
+//    for (auto& weakWindow : *s_windows.snapshot()) { ... }
+//    s_windows.remove(handle);
+//
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+template <typename T>
+struct snapshot_registry
+{
+    using handle = size_t;
+    using snapshot_type = std::shared_ptr<const std::vector<T>>;
+
+    snapshot_registry() = default;
+    snapshot_registry(const snapshot_registry&) = delete;
+    snapshot_registry& operator=(const snapshot_registry&) = delete;
+
+    [[nodiscard]] handle add(T value)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        handle result;
+        if (m_freeSlots.empty())
+        {
+            result = m_slots.size();
+            m_slots.emplace_back(std::move(value));
+        }
+        else
+        {
+            result = m_freeSlots.back();
+            m_freeSlots.pop_back();
+            m_slots[result].emplace(std::move(value));
+        }
+        publish();
+        return result;
+    }
+
+    void remove(handle slot)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        assert((slot < m_slots.size()) && m_slots[slot] && "the slot was not added or was already removed");
+        if ((slot >= m_slots.size()) || !m_slots[slot])
+        {
+            return; // removing it again would put it on the free list twice
+        }
+        m_slots[slot].reset();
+        m_freeSlots.push_back(slot);
+        publish();
+    }
+
+    // The values present at the time of the call, in slot order. Never null.
+    snapshot_type snapshot() const
+    {
+        return m_snapshot.load(std::memory_order_acquire);
+    }
+
+private:
+    void publish()
+    {
+        auto values = std::make_shared<std::vector<T>>();
+        values->reserve(m_slots.size() - m_freeSlots.size());
+        for (const auto& slot : m_slots)
+        {
+            if (slot)
+            {
+                values->push_back(*slot);
+            }
+        }
+        m_snapshot.store(std::move(values), std::memory_order_release);
+    }
+
+    std::mutex m_lock; // serializes writers
+    std::vector<std::optional<T>> m_slots;
+    std::vector<handle> m_freeSlots;
+    std::atomic<snapshot_type> m_snapshot{std::make_shared<const std::vector<T>>()};
+};
+} // namespace win32app
@@ -0,0 +1,256 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// startup_trace
+//
+// Lightweight timeline tracing, to see where start up time goes. Scoped trace points record a
+// complete event (name, thread, start, duration) into a ring buffer owned by the recording thread,
+// recording takes no lock. The rings of all threads are written out in the Chrome trace event
+// JSON format that chrome://tracing and Perfetto (ui.perfetto.dev) load.
+//
+// The library paths that dominate start up have trace points: Application creation, WindowsXamlManager
+// initialization, window class registration, window creation, Xaml parsing and WM_PAINT. They compile
+// to nothing unless WIN32APP_ENABLE_TRACING is defined before the headers are included.
+//
+//    WIN32APP_TRACE_SCOPE("LoadSettings");          // traces until the end of the enclosing scope
+//    WIN32APP_TRACE_THREAD_NAME("window thread");
+//
+//    std::ofstream file("startup.json");
+//    win32app::trace_log::instance().write_chrome_trace(file);
+//
+// Names must be string literals or otherwise live until the trace is written. Each thread keeps its
+// most recent trace_ring::c_capacity events, write the trace when start up is done. Events being
+// recorded while the trace is written are skipped.
+// This has no dependency on the Windows headers.
+
+#if defined(WIN32APP_ENABLE_TRACING)
+#define WIN32APP_TRACE_CONCAT_INNER(a, b) a##b
+#define WIN32APP_TRACE_CONCAT(a, b) WIN32APP_TRACE_CONCAT_INNER(a, b)
+#define WIN32APP_TRACE_SCOPE(name) const ::win32app::trace_scope WIN32APP_TRACE_CONCAT(win32appTraceScope, __LINE__)(name)
+#define WIN32APP_TRACE_THREAD_NAME(name) ::win32app::trace_log::instance().set_thread_name(name)
+#elif !defined(WIN32APP_TRACE_SCOPE) // also defined by win32_app_helpers.h when tracing is off
+#define WIN32APP_TRACE_SCOPE(name) \
+    do \
+    { \
+    } while (0)
+#define WIN32APP_TRACE_THREAD_NAME(name) \
+    do \
+    { \
+    } while (0)
+#endif
+
+namespace win32app
+{
+struct trace_event
+{
+    const char* name;
+    int64_t start_ns; // relative to the creation of the trace_log
+    int64_t duration_ns;
+};
+
+// Written by one thread, read by any. Each slot has a sequence number that is odd while the slot is
+// being written and 2 * n once it holds the nth event written to it, readers skip slots that do not
+// hold the event they expect, those being written, overwritten before or while they are read.
+struct trace_ring
+{
+    static constexpr size_t c_capacity = 4096;
+
+    explicit trace_ring(uint32_t threadId) : m_threadId(threadId)
+    {
+    }
+
+    // Only called by the owning thread.
+    void record(const char* name, int64_t startNs, int64_t durationNs)
+    {
+        const auto index = m_written.load(std::memory_order_relaxed);
+        auto& entry = m_slots[index % c_capacity];
+        const auto sequence = entry.sequence.load(std::memory_order_relaxed);
+        entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        entry.name.store(name, std::memory_order_relaxed);
+        entry.startNs.store(startNs, std::memory_order_relaxed);
+        entry.durationNs.store(durationNs, std::memory_order_relaxed);
+        entry.sequence.store(sequence + 2, std::memory_order_release);
+        m_written.store(index + 1, std::memory_order_release);
+    }
+
+    // The events still in the ring, oldest first.
+    std::vector<trace_event> events() const
+    {
+        const auto written = m_written.load(std::memory_order_acquire);
+        const auto first = (written > c_capacity) ? (written - c_capacity) : 0;
+
+        std::vector<trace_event> result;
+        result.reserve(static_cast<size_t>(written - first));
+        for (auto i = first; i < written; i++)
+        {
+            const auto& entry = m_slots[i % c_capacity];
+            const auto expected = 2 * (i / c_capacity + 1); // the sequence once event i is written
+            const auto before = entry.sequence.load(std::memory_order_acquire);
+            trace_event event{entry.name.load(std::memory_order_relaxed), entry.startNs.load(std::memory_order_relaxed),
+                              entry.durationNs.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((before == expected) && (entry.sequence.load(std::memory_order_relaxed) == expected))
+            {
+                result.push_back(event);
+            }
+        }
+        return result;
+    }
+
+    uint32_t thread_id() const
+    {
+        return m_threadId;
+    }
+
+    std::atomic<const char*> thread_name{nullptr};
+
+private:
+    struct ring_slot
+    {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int64_t> startNs{0};
+        std::atomic<int64_t> durationNs{0};
+    };
+
+    const uint32_t m_threadId;
+    std::atomic<uint64_t> m_written{0};
+    ring_slot m_slots[c_capacity];
+};
+
+struct trace_log
+{
+    using clock = std::chrono::steady_clock;
+
+    static trace_log& instance()
+    {
+        static trace_log s_log;
+        return s_log;
+    }
+
+    int64_t now_ns() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count();
+    }
+
+    void record(const char* name, int64_t startNs, int64_t durationNs)
+    {
+        current_ring().record(name, startNs, durationNs);
+    }
+
+    void set_thread_name(const char* name)
+    {
+        current_ring().thread_name.store(name, std::memory_order_release);
+    }
+
+    // The ring of the calling thread, created on first use. Rings are kept after their thread exits.
+    trace_ring& current_ring()
+    {
+        thread_local trace_ring* t_ring{};
+        if (!t_ring)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_rings.emplace_back(std::make_unique<trace_ring>(static_cast<uint32_t>(m_rings.size() + 1)));
+            t_ring = m_rings.back().get();
+        }
+        return *t_ring;
+    }
+
+    // Chrome trace event format, "X" (complete) events with times in microseconds.
+    void write_chrome_trace(std::ostream& out) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        auto separator = [&]() -> std::ostream& {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            return out;
+        };
+
+        for (const auto& ring : m_rings)
+        {
+            if (auto threadName = ring->thread_name.load(std::memory_order_acquire))
+            {
+                separator() << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << ring->thread_id() << R"(,"args":{"name":)";
+                write_json_string(out, threadName) << "}}";
+            }
+            for (const auto& event : ring->events())
+            {
+                separator() << R"({"name":)";
+                write_json_string(out, event.name) << R"(,"cat":"win32app","ph":"X","pid":1,"tid":)" << ring->thread_id() << R"(,"ts":)";
+                write_microseconds(out, event.start_ns) << R"(,"dur":)";
+                write_microseconds(out, event.duration_ns) << "}";
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+private:
+    trace_log() = default;
+
+    static std::ostream& write_json_string(std::ostream& out, const char* text)
+    {
+        static constexpr char c_hex[] = "0123456789abcdef";
+        out << '"';
+        for (auto ch = text; *ch; ch++)
+        {
+            const auto value = static_cast<unsigned char>(*ch);
+            if ((value == '"') || (value == '\\'))
+            {
+                out << '\\' << *ch;
+            }
+            else if (value < 0x20)
+            {
+                out << "\\u00" << c_hex[value >> 4] << c_hex[value & 0xF];
+            }
+            else
+            {
+                out << *ch;
+            }
+        }
+        return out << '"';
+    }
+
+    // Fixed 3 decimal places, without changing the stream's formatting state.
+    static std::ostream& write_microseconds(std::ostream& out, int64_t ns)
+    {
+        const auto fraction = ns % 1000;
+        out << (ns / 1000) << '.';
+        return out << static_cast<char>('0' + fraction / 100) << static_cast<char>('0' + (fraction / 10) % 10)
+                   << static_cast<char>('0' + fraction % 10);
+    }
+
+    const clock::time_point m_start{clock::now()};
+    mutable std::mutex m_lock; // the list of rings
+    std::vector<std::unique_ptr<trace_ring>> m_rings;
+};
+
+// Records an event from construction to destruction, normally used through WIN32APP_TRACE_SCOPE.
+struct trace_scope
+{
+    explicit trace_scope(const char* name) : m_name(name), m_startNs(trace_log::instance().now_ns())
+    {
+    }
+
+    ~trace_scope()
+    {
+        auto& log = trace_log::instance();
+        log.record(m_name, m_startNs, log.now_ns() - m_startNs);
+    }
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+private:
+    const char* m_name;
+    int64_t m_startNs;
+};
+} // namespace win32app
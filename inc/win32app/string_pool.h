@@ -0,0 +1,254 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// string_pool
+//
+// Storage for the strings read from many windows without an allocation per string.
+//
+// small_string keeps up to Capacity characters inline, on the stack when it is a local, and only
+// allocates for longer strings. The Win32 functions that read strings write into it directly:
+//
+//    win32app::small_wstring<128> text;
+//    text.resize(GetWindowTextW(window, text.data(), static_cast<int>(text.capacity())));
+//
+// string_pool appends strings to one buffer and returns their index, when a batch is done it is cleared
+// and the buffer is reused. append_with() lets the string be written in place.
+//
+// class_name_cache maps a window class atom to its name. The classes in use are a small set that is
+// shared by most windows, so only the first window of each class has its name read.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+template <typename TChar, size_t Capacity>
+struct small_string
+{
+    static_assert(Capacity > 0);
+
+    small_string()
+    {
+        m_inline[0] = TChar{};
+    }
+
+    small_string(std::basic_string_view<TChar> value) : small_string()
+    {
+        assign(value);
+    }
+
+    small_string(const small_string& other) : small_string()
+    {
+        assign(other.view());
+    }
+
+    small_string& operator=(const small_string& other)
+    {
+        if (this != &other)
+        {
+            assign(other.view());
+        }
+        return *this;
+    }
+
+    void assign(std::basic_string_view<TChar> value)
+    {
+        reserve(value.size() + 1);
+        std::copy(value.begin(), value.end(), data());
+        resize(value.size());
+    }
+
+    // Ensures capacity() >= count, the content is not kept.
+    void reserve(size_t count)
+    {
+        if (count > capacity())
+        {
+            m_heap = std::make_unique<TChar[]>(count);
+            m_heapCapacity = count;
+        }
+    }
+
+    // The space that can be written, including the null terminator.
+    size_t capacity() const
+    {
+        return m_heap ? m_heapCapacity : Capacity;
+    }
+
+    TChar* data()
+    {
+        return m_heap ? m_heap.get() : m_inline;
+    }
+
+    const TChar* data() const
+    {
+        return m_heap ? m_heap.get() : m_inline;
+    }
+
+    const TChar* c_str() const
+    {
+        return data();
+    }
+
+    // Sets the length after the data was written, the terminator is written at size.
+    void resize(size_t size)
+    {
+        m_size = std::min<size_t>(size, capacity() - 1);
+        data()[m_size] = TChar{};
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    bool is_inline() const
+    {
+        return !m_heap;
+    }
+
+    std::basic_string_view<TChar> view() const
+    {
+        return {data(), m_size};
+    }
+
+    operator std::basic_string_view<TChar>() const
+    {
+        return view();
+    }
+
+private:
+    TChar m_inline[Capacity]; // not initialized beyond the terminator
+    std::unique_ptr<TChar[]> m_heap;
+    size_t m_heapCapacity{};
+    size_t m_size{};
+};
+
+template <size_t Capacity>
+using small_wstring = small_string<wchar_t, Capacity>;
+
+template <typename TChar>
+struct basic_string_pool
+{
+    void reserve(size_t count, size_t characters)
+    {
+        m_offsets.reserve(count + 1);
+        m_text.reserve(characters);
+    }
+
+    uint32_t append(std::basic_string_view<TChar> value)
+    {
+        return append_with(value.size(), [&](TChar* buffer, size_t) {
+            std::copy(value.begin(), value.end(), buffer);
+            return value.size();
+        });
+    }
+
+    // write(buffer, capacity) writes up to capacity characters and returns the number written. capacity is
+    // maxLength + 1, space for a terminator, which is not required. Returns the index of the string.
+    template <typename TWrite>
+    uint32_t append_with(size_t maxLength, TWrite&& write)
+    {
+        if (m_offsets.empty())
+        {
+            m_offsets.push_back(0);
+        }
+        const auto start = m_text.size();
+        m_text.resize(start + maxLength + 1);
+        const auto written = std::min<size_t>(write(m_text.data() + start, maxLength + 1), maxLength);
+        m_text.resize(start + written + 1);
+        m_text.back() = TChar{};
+        m_offsets.push_back(static_cast<uint32_t>(m_text.size()));
+        return static_cast<uint32_t>(m_offsets.size() - 2);
+    }
+
+    // Removes the last string, to append it again when the space given to append_with() was too small.
+    void pop_back()
+    {
+        m_offsets.pop_back();
+        m_text.resize(m_offsets.back());
+    }
+
+    size_t size() const
+    {
+        return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+    }
+
+    std::basic_string_view<TChar> operator[](size_t index) const
+    {
+        return {m_text.data() + m_offsets[index], m_offsets[index + 1] - m_offsets[index] - 1};
+    }
+
+    const TChar* c_str(size_t index) const
+    {
+        return m_text.data() + m_offsets[index];
+    }
+
+    // Removes the strings and keeps the memory for the next batch.
+    void clear()
+    {
+        m_text.clear();
+        m_offsets.clear();
+    }
+
+private:
+    std::vector<TChar> m_text;
+    std::vector<uint32_t> m_offsets;
+};
+
+using string_pool = basic_string_pool<wchar_t>;
+
+// Thread safe, lookups take a shared lock. Names are never removed, views stay valid for the life of the cache.
+struct class_name_cache
+{
+    std::optional<std::wstring_view> find(uint16_t atom) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_lock);
+        const auto found = m_names.find(atom);
+        if (found == m_names.end())
+        {
+            return std::nullopt;
+        }
+        return found->second;
+    }
+
+    // Returns the cached name, which is name unless another thread inserted first.
+    std::wstring_view insert(uint16_t atom, std::wstring_view name)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_lock);
+        return m_names.try_emplace(atom, name).first->second;
+    }
+
+    // read() returns the name when the atom is not cached yet.
+    template <typename TRead>
+    std::wstring_view get(uint16_t atom, TRead&& read)
+    {
+        if (auto name = find(atom))
+        {
+            return *name;
+        }
+        return insert(atom, read());
+    }
+
+    size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_lock);
+        return m_names.size();
+    }
+
+private:
+    mutable std::shared_mutex m_lock;
+    std::unordered_map<uint16_t, std::wstring> m_names; // node based, the strings do not move
+};
+} // namespace win32app
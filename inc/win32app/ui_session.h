@@ -0,0 +1,185 @@
+#pragma once
+#include <chrono>
+#include <optional>
+#include <utility>
+
+// ui_session
+//
+// Keeps a UI thread, and optionally its window, alive across many calls that need to run code on a
+// UI thread, for example UI automation tests. Starting a thread and creating a window per call
+// dominates the cost of short calls, the session pays for that once and resets the content
+// between calls instead. Per call overhead is reported, that is the time to start the thread and
+// window when needed, to get onto the UI thread and to reset the content afterwards.
+//
+// The UI work is done by TBackend, XamlHostWindow::SessionBackend is the Xaml implementation.
+// TBackend provides
+//    void start_thread();
+//    void stop_thread();
+//    void create_window();
+//    void destroy_window();
+//    void reset_content();
+//    template <typename Fn> void run(Fn&& fn); // runs fn(window) on the UI thread and waits for it and its result
+// and optionally
+//    void log_current_exception() noexcept;    // called in a catch block when the destructor fails to stop the session
+//
+//    win32app::ui_session<XamlHostWindow::SessionBackend> session;
+//    session.run([](XamlHostWindow& window) { ... });
+//    session.run([](XamlHostWindow& window) { ... }); // same thread and window, content reset
+//
+// If fn throws the session is torn down and started again by the next call.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct ui_session_options
+{
+    bool keep_window = true; // false creates and destroys the window for each call, keeping the thread
+};
+
+struct ui_session_stats
+{
+    size_t calls;
+    size_t thread_starts;
+    size_t window_creates;
+    std::chrono::nanoseconds last_overhead;
+    std::chrono::nanoseconds total_overhead;
+    std::chrono::nanoseconds total_run_time; // time spent running the callers functions
+};
+
+template <typename TBackend>
+struct ui_session
+{
+    using clock = std::chrono::steady_clock;
+
+    explicit ui_session(TBackend backend = {}, ui_session_options options = {}) : m_backend(std::move(backend)), m_options(options)
+    {
+    }
+
+    ~ui_session()
+    {
+        try
+        {
+            stop();
+        }
+        catch (...)
+        {
+            if constexpr (requires(TBackend& backend) { backend.log_current_exception(); })
+            {
+                m_backend.log_current_exception();
+            }
+        }
+    }
+
+    ui_session(const ui_session&) = delete;
+    ui_session& operator=(const ui_session&) = delete;
+
+    template <typename Fn>
+    void run(Fn&& fn)
+    {
+        const auto callStart = clock::now();
+        clock::duration runTime{};
+        try
+        {
+            ensure_window();
+            std::optional<clock::time_point> runStart; // stays empty if the backend did not call fn
+            m_backend.run([&](auto& window) -> decltype(auto) {
+                runStart = clock::now(); // the backend may wait for the result, for example an async operation
+                return fn(window);
+            });
+            if (runStart)
+            {
+                runTime = clock::now() - *runStart;
+            }
+
+            if (m_options.keep_window)
+            {
+                m_backend.reset_content();
+            }
+            else
+            {
+                destroy_window();
+            }
+        }
+        catch (...)
+        {
+            stop(); // unknown state, start over on the next call
+            throw;
+        }
+
+        const auto overhead = std::chrono::duration_cast<std::chrono::nanoseconds>((clock::now() - callStart) - runTime);
+        m_stats.calls++;
+        m_stats.last_overhead = overhead;
+        m_stats.total_overhead += overhead;
+        m_stats.total_run_time += std::chrono::duration_cast<std::chrono::nanoseconds>(runTime);
+    }
+
+    // The thread is stopped even if destroying the window fails.
+    void stop()
+    {
+        try
+        {
+            destroy_window();
+        }
+        catch (...)
+        {
+            stop_thread();
+            throw;
+        }
+        stop_thread();
+    }
+
+    bool is_running() const
+    {
+        return m_threadStarted;
+    }
+
+    ui_session_stats stats() const
+    {
+        return m_stats;
+    }
+
+    TBackend& backend()
+    {
+        return m_backend;
+    }
+
+private:
+    void ensure_window()
+    {
+        if (!m_threadStarted)
+        {
+            m_backend.start_thread();
+            m_threadStarted = true;
+            m_stats.thread_starts++;
+        }
+        if (!m_windowCreated)
+        {
+            m_backend.create_window();
+            m_windowCreated = true;
+            m_stats.window_creates++;
+        }
+    }
+
+    void destroy_window()
+    {
+        if (std::exchange(m_windowCreated, false))
+        {
+            m_backend.destroy_window();
+        }
+    }
+
+    void stop_thread()
+    {
+        if (std::exchange(m_threadStarted, false))
+        {
+            m_backend.stop_thread();
+        }
+    }
+
+    TBackend m_backend;
+    const ui_session_options m_options;
+    bool m_threadStarted{};
+    bool m_windowCreated{};
+    ui_session_stats m_stats{};
+};
+} // namespace win32app
@@ -0,0 +1,277 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// ui_thread_placement
+//
+// Chooses which of a fixed set of UI threads hosts a new window and tracks the load of each thread.
+// Load is measured from the work dispatched to the windows of a thread and the messages they handle:
+// the number of queued work items and a moving average of the time the handlers take. The expected wait for new work on a
+// thread is about queued * average handler time, ties are broken by the number of windows.
+//
+// Policies
+//   least_loaded    place on the thread with the lowest expected wait.
+//   round_robin     place on each thread in turn, ignoring load.
+// Windows given an affinity group are placed on the same thread as the other windows of that
+// group, the first one of a group is placed using the policy.
+//
+//    win32app::ui_thread_placement placement(4);
+//    auto slot = placement.place(); // keep for the lifetime of the window
+//
+//    auto work = slot.queue_work(); // when dispatching work to the window's thread
+//    ...
+//    work.start();                  // when the work runs, the handler time is recorded when work is destroyed
+//
+//    slot.record_handler_time(elapsed); // for the messages handled by the window
+//
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+enum class placement_policy
+{
+    least_loaded,
+    round_robin,
+};
+
+struct ui_thread_load
+{
+    uint32_t windows;
+    uint32_t queued;
+    std::chrono::nanoseconds average_handler_time;
+};
+
+struct ui_thread_placement
+{
+    using clock = std::chrono::steady_clock;
+
+    explicit ui_thread_placement(size_t threadCount, placement_policy policy = placement_policy::least_loaded) :
+        m_threads(threadCount), m_policy(policy)
+    {
+    }
+
+    ui_thread_placement(const ui_thread_placement&) = delete;
+    ui_thread_placement& operator=(const ui_thread_placement&) = delete;
+
+private:
+    struct thread_state
+    {
+        void record_handler_time(clock::duration duration)
+        {
+            // Exponential moving average with a weight of 1/8 for the new sample, races between threads only lose samples.
+            const auto sample = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            const auto average = averageHandlerNs.load(std::memory_order_relaxed);
+            averageHandlerNs.store(average + (sample - average) / 8, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint32_t> windows{0};
+        std::atomic<uint32_t> queued{0};
+        std::atomic<int64_t> averageHandlerNs{0};
+    };
+
+public:
+    // Tracks one work item dispatched to a thread, it counts as queued until start() is called and the
+    // time from start() to destruction is recorded as handler time.
+    struct work_item
+    {
+        ~work_item()
+        {
+            if (auto state = std::exchange(m_state, nullptr))
+            {
+                if (m_started)
+                {
+                    state->record_handler_time(clock::now() - m_start);
+                }
+                else
+                {
+                    state->queued.fetch_sub(1, std::memory_order_relaxed); // abandoned
+                }
+            }
+        }
+
+        work_item(const work_item&) = delete;
+        work_item& operator=(const work_item&) = delete;
+        work_item& operator=(work_item&&) = delete;
+
+        work_item(work_item&& other) noexcept :
+            m_state(std::exchange(other.m_state, nullptr)), m_start(other.m_start), m_started(other.m_started)
+        {
+        }
+
+        void start()
+        {
+            m_state->queued.fetch_sub(1, std::memory_order_relaxed);
+            m_start = clock::now();
+            m_started = true;
+        }
+
+    private:
+        friend ui_thread_placement;
+
+        explicit work_item(thread_state& state) : m_state(&state)
+        {
+            m_state->queued.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        thread_state* m_state;
+        clock::time_point m_start{};
+        bool m_started{};
+    };
+
+    // Represents a window placed on a thread, releases the placement when destroyed.
+    // Also the interface to report the work done for the window.
+    struct window_slot
+    {
+        window_slot(ui_thread_placement& placement, size_t thread, std::optional<uint32_t> group) :
+            m_placement(&placement), m_thread(thread), m_group(group)
+        {
+        }
+
+        ~window_slot()
+        {
+            reset();
+        }
+
+        window_slot(const window_slot&) = delete;
+        window_slot& operator=(const window_slot&) = delete;
+
+        window_slot(window_slot&& other) noexcept :
+            m_placement(std::exchange(other.m_placement, nullptr)), m_thread(other.m_thread), m_group(other.m_group)
+        {
+        }
+
+        window_slot& operator=(window_slot&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                m_placement = std::exchange(other.m_placement, nullptr);
+                m_thread = other.m_thread;
+                m_group = other.m_group;
+            }
+            return *this;
+        }
+
+        size_t thread() const
+        {
+            return m_thread;
+        }
+
+        // Call when work for the window is dispatched to its thread, keep the result until the work completes.
+        [[nodiscard]] work_item queue_work() const
+        {
+            return work_item(m_placement->m_threads[m_thread]);
+        }
+
+        // For the time spent handling a message, which was not queued through queue_work().
+        void record_handler_time(clock::duration duration) const
+        {
+            m_placement->m_threads[m_thread].record_handler_time(duration);
+        }
+
+        void reset()
+        {
+            if (auto placement = std::exchange(m_placement, nullptr))
+            {
+                placement->remove(m_thread, m_group);
+            }
+        }
+
+    private:
+        ui_thread_placement* m_placement;
+        size_t m_thread;
+        std::optional<uint32_t> m_group;
+    };
+
+    [[nodiscard]] window_slot place(std::optional<uint32_t> affinityGroup = std::nullopt)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        size_t thread;
+        if (auto existing = affinityGroup ? m_groups.find(*affinityGroup) : m_groups.end(); existing != m_groups.end())
+        {
+            thread = existing->second.thread;
+            existing->second.windows++;
+        }
+        else
+        {
+            thread = choose_thread();
+            if (affinityGroup)
+            {
+                m_groups.emplace(*affinityGroup, group_state{thread, 1});
+            }
+        }
+        m_threads[thread].windows.fetch_add(1, std::memory_order_relaxed);
+        return window_slot(*this, thread, affinityGroup);
+    }
+
+    size_t thread_count() const
+    {
+        return m_threads.size();
+    }
+
+    ui_thread_load load(size_t thread) const
+    {
+        const auto& state = m_threads[thread];
+        return {state.windows.load(std::memory_order_relaxed), state.queued.load(std::memory_order_relaxed),
+                std::chrono::nanoseconds{state.averageHandlerNs.load(std::memory_order_relaxed)}};
+    }
+
+private:
+    struct group_state
+    {
+        size_t thread;
+        uint32_t windows;
+    };
+
+    size_t choose_thread()
+    {
+        if (m_policy == placement_policy::round_robin)
+        {
+            return m_nextThread++ % m_threads.size();
+        }
+
+        size_t best = 0;
+        for (size_t i = 1; i < m_threads.size(); i++)
+        {
+            if (is_less_loaded(load(i), load(best)))
+            {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    static bool is_less_loaded(const ui_thread_load& left, const ui_thread_load& right)
+    {
+        const auto leftWait = left.queued * left.average_handler_time;
+        const auto rightWait = right.queued * right.average_handler_time;
+        return (leftWait != rightWait) ? (leftWait < rightWait) : (left.windows < right.windows);
+    }
+
+    void remove(size_t thread, std::optional<uint32_t> group)
+    {
+        m_threads[thread].windows.fetch_sub(1, std::memory_order_relaxed);
+        if (group)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (auto existing = m_groups.find(*group); (existing != m_groups.end()) && (--existing->second.windows == 0))
+            {
+                m_groups.erase(existing);
+            }
+        }
+    }
+
+    std::vector<thread_state> m_threads;
+    const placement_policy m_policy;
+    std::mutex m_lock; // placement and the groups
+    std::unordered_map<uint32_t, group_state> m_groups;
+    size_t m_nextThread{};
+};
+} // namespace win32app
@@ -0,0 +1,162 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "utf8_validation.h"
+
+// utf16_string_table
+//
+// Converts a table of UTF-8 strings (localization tables, lookup tables) to UTF-16 in one batch.
+// The result is one contiguous, null terminated, arena of text plus an array of offsets, avoiding
+// a std::wstring allocation per entry. Large tables are converted in parallel.
+//
+//    auto table = win32app::make_utf16_string_table(win32app::split_utf8_blob(get_resource_view(L"Strings.txt"), '\n'));
+//    std::wstring_view name = (*table)[index];
+//
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+template <typename TChar = wchar_t>
+struct basic_utf16_string_table
+{
+    size_t size() const noexcept
+    {
+        return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+    }
+
+    std::basic_string_view<TChar> operator[](size_t index) const noexcept
+    {
+        return {m_text.data() + m_offsets[index], m_offsets[index + 1] - m_offsets[index] - 1};
+    }
+
+    // Entries are null terminated, enabling their use with APIs that take PCWSTR.
+    const TChar* c_str(size_t index) const noexcept
+    {
+        return m_text.data() + m_offsets[index];
+    }
+
+    std::span<const TChar> text() const noexcept
+    {
+        return m_text;
+    }
+
+    // size() + 1 entries, entry i spans [offsets[i], offsets[i + 1] - 1), the last character is the null.
+    std::span<const uint32_t> offsets() const noexcept
+    {
+        return m_offsets;
+    }
+
+    std::vector<TChar> m_text;
+    std::vector<uint32_t> m_offsets;
+};
+
+using utf16_string_table = basic_utf16_string_table<wchar_t>;
+
+// Splits a blob of delimited entries, for example a '\n' or '\0' separated resource. A trailing delimiter does not produce an empty entry.
+inline std::vector<std::string_view> split_utf8_blob(std::string_view blob, char delimiter)
+{
+    std::vector<std::string_view> result;
+    result.reserve(static_cast<size_t>(std::count(blob.begin(), blob.end(), delimiter)) + 1);
+    while (!blob.empty())
+    {
+        const auto end = blob.find(delimiter);
+        result.push_back(blob.substr(0, end));
+        blob.remove_prefix((end == std::string_view::npos) ? blob.size() : end + 1);
+    }
+    return result;
+}
+
+namespace details
+{
+    // Runs fn(begin, end) over ranges of [0, count), on multiple threads when the work is large enough to pay for them.
+    template <typename TFn>
+    void for_each_range(size_t count, size_t workSize, unsigned int threadCount, TFn&& fn)
+    {
+        constexpr size_t minWorkPerThread = 256 * 1024; // bytes
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threadCount = static_cast<unsigned int>(std::min<size_t>({threadCount, count, std::max<size_t>(1, workSize / minWorkPerThread)}));
+        if (threadCount <= 1)
+        {
+            fn(size_t{0}, count);
+            return;
+        }
+
+        // jthread joins when destroyed, if starting a thread throws the threads already started are joined
+        // before the exception leaves.
+        std::vector<std::jthread> threads;
+        threads.reserve(threadCount - 1);
+        const size_t perThread = (count + threadCount - 1) / threadCount;
+        for (size_t begin = perThread; begin < count; begin += perThread)
+        {
+            threads.emplace_back([&fn, begin, end = std::min(begin + perThread, count)] { fn(begin, end); });
+        }
+        fn(size_t{0}, std::min(perThread, count));
+    }
+} // namespace details
+
+// Returns nothing if any entry is not valid UTF-8. threadCount == 0 uses all cores for large tables.
+template <typename TChar = wchar_t>
+std::optional<basic_utf16_string_table<TChar>> make_utf16_string_table(std::span<const std::string_view> entries, unsigned int threadCount = 0)
+{
+    size_t totalBytes = 0;
+    for (auto entry : entries)
+    {
+        totalBytes += entry.size();
+    }
+
+    // Pass 1, validate and measure each entry. The lengths are stored in the offsets array, shifted by one.
+    basic_utf16_string_table<TChar> result;
+    result.m_offsets.resize(entries.size() + 1);
+    std::atomic<bool> valid{true};
+    details::for_each_range(entries.size(), totalBytes, threadCount, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++)
+        {
+            const auto validation = validate_utf8(entries[i]);
+            if (!validation.valid)
+            {
+                valid.store(false, std::memory_order_relaxed);
+                return;
+            }
+            result.m_offsets[i + 1] = static_cast<uint32_t>(std::min<size_t>(validation.utf16_length + 1, std::numeric_limits<uint32_t>::max()));
+        }
+    });
+    if (!valid.load())
+    {
+        return std::nullopt;
+    }
+
+    // Convert the lengths to offsets.
+    uint64_t offset = 0;
+    for (auto& entry : result.m_offsets)
+    {
+        offset += entry;
+        if (offset > std::numeric_limits<uint32_t>::max())
+        {
+            return std::nullopt; // too large for 32 bit offsets
+        }
+        entry = static_cast<uint32_t>(offset);
+    }
+
+    // Pass 2, convert each entry into its place in the arena.
+    result.m_text.resize(static_cast<size_t>(offset));
+    details::for_each_range(entries.size(), totalBytes, threadCount, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++)
+        {
+            details::utf8_to_utf16_unchecked(entries[i], result.m_text.data() + result.m_offsets[i]);
+            result.m_text[result.m_offsets[i + 1] - 1] = TChar{};
+        }
+    });
+    return result;
+}
+} // namespace win32app
@@ -8,6 +8,10 @@
 #include <wil/stl.h>
 #include <wil/filesystem.h>
 
+#include "compressed_resource.h"
+#include "resource_cache.h"
+#include "utf8_validation.h"
+
 inline std::wstring from_utf8(std::string_view text)
 {
     if (text.length() == 0)
@@ -15,14 +19,22 @@ inline std::wstring from_utf8(std::string_view text)
         return std::wstring{};
     }
 
-    int bufferSize{MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.length()), nullptr, 0)};
-
-    FAIL_FAST_IF(bufferSize == 0); // Should not occur, but do not ignore unexpected errors.
+    // One pass to validate and size the result replaces the sizing call to MultiByteToWideChar.
+    const auto validation = win32app::validate_utf8(text);
+    if (!validation.valid)
+    {
+        THROW_WIN32(ERROR_NO_UNICODE_TRANSLATION); // what MultiByteToWideChar(MB_ERR_INVALID_CHARS) reports
+    }
 
-    std::wstring buffer(bufferSize, '\0');
+    std::wstring buffer(validation.utf16_length, L'\0');
+    if (validation.ascii_only)
+    {
+        std::copy(text.begin(), text.end(), buffer.begin()); // widen, no conversion needed
+        return buffer;
+    }
 
-    int written{MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, text.data(), static_cast<int>(text.length()), &buffer[0], bufferSize)};
-    THROW_LAST_ERROR_IF(written != bufferSize);
+    int written{MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, text.data(), static_cast<int>(text.length()), &buffer[0], static_cast<int>(buffer.size()))};
+    THROW_LAST_ERROR_IF(written != static_cast<int>(buffer.size()));
 
     return buffer;
 }
@@ -98,3 +110,95 @@ inline std::basic_string_view<T> get_resource_view(UINT resourceId, PCWSTR type
 {
     return get_resource_view<T>(MAKEINTRESOURCEW(resourceId), type, module);
 }
+
+namespace win32app::details
+{
+    inline win32app::resource_cache<std::string_view>& resource_view_cache()
+    {
+        static win32app::resource_cache<std::string_view> s_cache;
+        return s_cache;
+    }
+
+    inline win32app::resource_cache<std::wstring_view>& resource_string_view_cache()
+    {
+        static win32app::resource_cache<std::wstring_view> s_cache;
+        return s_cache;
+    }
+
+    inline win32app::resource_cache<std::string>& decompressed_resource_cache()
+    {
+        static win32app::resource_cache<std::string> s_cache;
+        return s_cache;
+    }
+
+    inline win32app::resource_cache<std::wstring>& decoded_resource_cache()
+    {
+        static win32app::resource_cache<std::wstring> s_cache;
+        return s_cache;
+    }
+} // namespace win32app::details
+
+// Cached versions of the functions above. The resource lookup is done once per module, name and type,
+// later calls return the same view without calling FindResourceW/LoadResource/SizeofResource.
+// Do not use these with modules that get unloaded.
+
+template <typename T = char> // default to UTF-8, use wchar_t for UTF-16
+std::basic_string_view<T> get_cached_resource_view(PCWSTR name, PCWSTR type = RT_RCDATA, HINSTANCE module = wil::GetModuleInstanceHandle())
+{
+    auto bytes = win32app::details::resource_view_cache().get_or_create(module, name, type, [&]() -> std::string_view {
+        return get_resource_view<char>(name, type, module);
+    });
+    return {reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T)};
+}
+
+inline std::wstring_view get_cached_resource_string_view(UINT resourceId, HINSTANCE module = wil::GetModuleInstanceHandle())
+{
+    return win32app::details::resource_string_view_cache().get_or_create(module, MAKEINTRESOURCEW(resourceId), RT_STRING, [&] {
+        return get_resource_string_view(resourceId, module);
+    });
+}
+
+// Returns the content of a resource that may have been compressed by Tools/compress_resource.cpp, see
+// win32app/compressed_resource.h. Compressed resources are decompressed on first use into a buffer that
+// is shared by all callers, other resources are returned as is.
+//
+// auto json = get_decompressed_resource_view(L"Settings.json");
+template <typename T = char> // default to UTF-8, use wchar_t for UTF-16
+std::basic_string_view<T> get_decompressed_resource_view(PCWSTR name, PCWSTR type = RT_RCDATA, HINSTANCE module = wil::GetModuleInstanceHandle())
+{
+    std::string_view bytes = get_cached_resource_view(name, type, module);
+    if (auto header = win32app::parse_compressed_resource_header(bytes))
+    {
+        bytes = win32app::details::decompressed_resource_cache().get_or_create(module, name, type, [&] {
+            auto content = win32app::decompress_resource(*header);
+            THROW_HR_IF_MSG(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), !content, "Corrupt or unsupported compressed resource");
+            return std::move(*content);
+        });
+    }
+    return {reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T)};
+}
+
+// Returns the UTF-16 form of a UTF-8 resource (the BOM is skipped). The conversion is done once and
+// shared by all callers, for example XAML markup loaded for every window of a given type.
+// The resource may be compressed, see get_decompressed_resource_view().
+//
+// auto xaml = get_decoded_resource_view(L"AppWindow.xaml");
+inline std::wstring_view get_decoded_resource_view(PCWSTR name, PCWSTR type = RT_RCDATA, HINSTANCE module = wil::GetModuleInstanceHandle())
+{
+    return win32app::details::decoded_resource_cache().get_or_create(module, name, type, [&] {
+        return from_utf8(skip_utf8_bom(get_decompressed_resource_view(name, type, module)));
+    });
+}
+
+// Hit and miss counts for the caches above, useful for validating the caches are effective.
+inline win32app::resource_cache_stats get_resource_cache_stats()
+{
+    win32app::resource_cache_stats result{};
+    for (auto stats : {win32app::details::resource_view_cache().stats(), win32app::details::resource_string_view_cache().stats(),
+                       win32app::details::decompressed_resource_cache().stats(), win32app::details::decoded_resource_cache().stats()})
+    {
+        result.hits += stats.hits;
+        result.misses += stats.misses;
+    }
+    return result;
+}
@@ -0,0 +1,425 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define WIN32APP_UTF8_SSE2 1
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define WIN32APP_UTF8_SSSE3 1
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define WIN32APP_UTF8_NEON 1
+#endif
+
+// validate_utf8
+//
+// Checks that text is well formed UTF-8 (the same rules MultiByteToWideChar applies with
+// MB_ERR_INVALID_CHARS: no overlong forms, no surrogates, nothing past U+10FFFF) without
+// converting or allocating. With NEON, or SSSE3 on x86 (-mssse3 or /arch:AVX and later), all text
+// is checked 16 bytes at a time using lookup tables indexed by the nibbles of each byte and the byte
+// before it, the method of Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per
+// Byte". With SSE2 only, runs of ASCII are skipped 16 bytes at a time and the multi-byte sequences
+// are checked one at a time.
+//
+//    auto result = win32app::validate_utf8(text);
+//    if (!result.valid) { /* result.error_offset is the start of the bad sequence */ }
+//
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct utf8_validation_result
+{
+    bool valid;
+    bool ascii_only;     // all bytes < 0x80, the UTF-16 form is a simple widening
+    size_t error_offset; // offset of the first invalid sequence, the text size when valid
+    size_t utf16_length; // exact number of UTF-16 code units needed, for the valid prefix when invalid
+};
+
+namespace details
+{
+    // Returns the number of leading bytes < 0x80.
+    inline size_t ascii_prefix_length(const unsigned char* bytes, size_t size) noexcept
+    {
+        size_t i = 0;
+#if defined(WIN32APP_UTF8_SSE2)
+        for (; i + 16 <= size; i += 16)
+        {
+            const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i))));
+            if (mask != 0)
+            {
+                return i + std::countr_zero(mask);
+            }
+        }
+#elif defined(WIN32APP_UTF8_NEON)
+        for (; i + 16 <= size; i += 16)
+        {
+            if (vmaxvq_u8(vld1q_u8(bytes + i)) >= 0x80)
+            {
+                break; // the scalar loop below finds the exact position
+            }
+        }
+#else
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t block;
+            memcpy(&block, bytes + i, sizeof(block));
+            if ((block & 0x8080808080808080ull) != 0)
+            {
+                break;
+            }
+        }
+#endif
+        while ((i < size) && (bytes[i] < 0x80))
+        {
+            i++;
+        }
+        return i;
+    }
+
+    // Returns the length of the well formed sequence at bytes[0] (a non-ASCII lead byte) or 0 if it is invalid.
+    // See "Well-Formed UTF-8 Byte Sequences" in chapter 3 of the Unicode standard.
+    inline size_t utf8_sequence_length(const unsigned char* bytes, size_t size) noexcept
+    {
+        const unsigned char lead = bytes[0];
+        size_t length;
+        unsigned char secondMin = 0x80, secondMax = 0xBF;
+        if ((lead >= 0xC2) && (lead <= 0xDF))
+        {
+            length = 2;
+        }
+        else if ((lead >= 0xE0) && (lead <= 0xEF))
+        {
+            length = 3;
+            if (lead == 0xE0)
+            {
+                secondMin = 0xA0; // overlong
+            }
+            else if (lead == 0xED)
+            {
+                secondMax = 0x9F; // surrogates
+            }
+        }
+        else if ((lead >= 0xF0) && (lead <= 0xF4))
+        {
+            length = 4;
+            if (lead == 0xF0)
+            {
+                secondMin = 0x90; // overlong
+            }
+            else if (lead == 0xF4)
+            {
+                secondMax = 0x8F; // past U+10FFFF
+            }
+        }
+        else
+        {
+            return 0; // continuation byte, overlong 2 byte lead (C0, C1) or F5..FF
+        }
+
+        if ((size < length) || (bytes[1] < secondMin) || (bytes[1] > secondMax))
+        {
+            return 0;
+        }
+        for (size_t i = 2; i < length; i++)
+        {
+            if ((bytes[i] & 0xC0) != 0x80)
+            {
+                return 0;
+            }
+        }
+        return length;
+    }
+
+#if defined(WIN32APP_UTF8_SSSE3) || defined(WIN32APP_UTF8_NEON)
+    // The error classes of a two byte window, a pair of bytes is invalid when the three lookups share one.
+    // Each table is indexed by a nibble: the high and low nibbles of the first byte and the high nibble of
+    // the second.
+    constexpr unsigned char c_tooShort = 1 << 0;  // a lead not followed by a continuation
+    constexpr unsigned char c_tooLong = 1 << 1;   // a continuation after ASCII
+    constexpr unsigned char c_overlong3 = 1 << 2; // E0 80..9F
+    constexpr unsigned char c_tooLarge = 1 << 3;  // F4 90..BF, F5..FF
+    constexpr unsigned char c_surrogate = 1 << 4; // ED A0..BF
+    constexpr unsigned char c_overlong2 = 1 << 5; // C0, C1
+    constexpr unsigned char c_tooLarge1000 = 1 << 6; // F5..FF 80..8F
+    constexpr unsigned char c_overlong4 = 1 << 6; // F0 80..8F
+    constexpr unsigned char c_twoContinuations = 1 << 7;
+    constexpr unsigned char c_carry = c_tooShort | c_tooLong | c_twoContinuations;
+
+    alignas(16) constexpr unsigned char c_byte1High[16]{c_tooLong, c_tooLong, c_tooLong, c_tooLong, c_tooLong, c_tooLong, c_tooLong,
+        c_tooLong, c_twoContinuations, c_twoContinuations, c_twoContinuations, c_twoContinuations, c_tooShort | c_overlong2, c_tooShort,
+        c_tooShort | c_overlong3 | c_surrogate, c_tooShort | c_tooLarge | c_tooLarge1000 | c_overlong4};
+
+    alignas(16) constexpr unsigned char c_byte1Low[16]{c_carry | c_overlong3 | c_overlong2 | c_overlong4, c_carry | c_overlong2, c_carry,
+        c_carry, c_carry | c_tooLarge, c_carry | c_tooLarge | c_tooLarge1000, c_carry | c_tooLarge | c_tooLarge1000,
+        c_carry | c_tooLarge | c_tooLarge1000, c_carry | c_tooLarge | c_tooLarge1000, c_carry | c_tooLarge | c_tooLarge1000,
+        c_carry | c_tooLarge | c_tooLarge1000, c_carry | c_tooLarge | c_tooLarge1000, c_carry | c_tooLarge | c_tooLarge1000,
+        c_carry | c_tooLarge | c_tooLarge1000 | c_surrogate, c_carry | c_tooLarge | c_tooLarge1000, c_carry | c_tooLarge | c_tooLarge1000};
+
+    alignas(16) constexpr unsigned char c_byte2High[16]{c_tooShort, c_tooShort, c_tooShort, c_tooShort, c_tooShort, c_tooShort, c_tooShort,
+        c_tooShort, c_tooLong | c_overlong2 | c_twoContinuations | c_overlong3 | c_tooLarge1000 | c_overlong4,
+        c_tooLong | c_overlong2 | c_twoContinuations | c_overlong3 | c_tooLarge,
+        c_tooLong | c_overlong2 | c_twoContinuations | c_surrogate | c_tooLarge,
+        c_tooLong | c_overlong2 | c_twoContinuations | c_surrogate | c_tooLarge, c_tooShort, c_tooShort, c_tooShort, c_tooShort};
+
+    // Subtracted with saturation from the last bytes of a block, non zero where a lead needs more bytes.
+    alignas(16) constexpr unsigned char c_incompleteMax[16]{
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF};
+
+#if defined(WIN32APP_UTF8_SSSE3)
+    struct utf8_block_checker
+    {
+        // Non zero bytes where input, with the block before it, is not well formed. A sequence that is cut
+        // off at the end of input is not an error here, see incomplete().
+        __m128i error(__m128i input, __m128i previous) const noexcept
+        {
+            const auto previous1 = _mm_alignr_epi8(input, previous, 15);
+            const auto special = _mm_and_si128(_mm_and_si128(_mm_shuffle_epi8(byte1High, _mm_and_si128(_mm_srli_epi16(previous1, 4), nibble)),
+                                                   _mm_shuffle_epi8(byte1Low, _mm_and_si128(previous1, nibble))),
+                _mm_shuffle_epi8(byte2High, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+            // 0x80 where the byte is the third or fourth of a sequence, those two byte windows are
+            // continuation pairs and must be flagged as such by the lookups.
+            const auto must23 = _mm_or_si128(_mm_subs_epu8(_mm_alignr_epi8(input, previous, 14), _mm_set1_epi8(static_cast<char>(0xE0 - 0x80))),
+                _mm_subs_epu8(_mm_alignr_epi8(input, previous, 13), _mm_set1_epi8(static_cast<char>(0xF0 - 0x80))));
+            return _mm_xor_si128(_mm_and_si128(must23, _mm_set1_epi8(static_cast<char>(0x80))), special);
+        }
+
+        // Non zero bytes where a lead in the last three bytes needs more bytes than the block has.
+        __m128i incomplete(__m128i input) const noexcept
+        {
+            return _mm_subs_epu8(input, incompleteMax);
+        }
+
+        // The UTF-16 code units of each byte: one if it is not a continuation (signed > 0xBF) and another for
+        // a 4 byte lead (negative and signed > 0xEF).
+        static __m128i utf16_units(__m128i input) noexcept
+        {
+            const auto leads = _mm_cmpgt_epi8(input, _mm_set1_epi8(static_cast<char>(0xBF)));
+            const auto fourByteLeads = _mm_and_si128(_mm_cmpgt_epi8(input, _mm_set1_epi8(static_cast<char>(0xEF))), _mm_cmplt_epi8(input, _mm_setzero_si128()));
+            return _mm_sub_epi8(_mm_setzero_si128(), _mm_add_epi8(leads, fourByteLeads));
+        }
+
+        static bool is_zero(__m128i value) noexcept
+        {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(value, _mm_setzero_si128())) == 0xFFFF;
+        }
+
+        static size_t sum(__m128i units) noexcept
+        {
+            const auto sums = _mm_sad_epu8(units, _mm_setzero_si128());
+            return static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+        }
+
+        __m128i byte1High = _mm_load_si128(reinterpret_cast<const __m128i*>(c_byte1High));
+        __m128i byte1Low = _mm_load_si128(reinterpret_cast<const __m128i*>(c_byte1Low));
+        __m128i byte2High = _mm_load_si128(reinterpret_cast<const __m128i*>(c_byte2High));
+        __m128i incompleteMax = _mm_load_si128(reinterpret_cast<const __m128i*>(c_incompleteMax));
+        __m128i nibble = _mm_set1_epi8(0x0F);
+    };
+#endif
+
+    // Checks bytes 16 at a time up to the first block with an error, returns the size of the blocks that
+    // passed and adds their UTF-16 length. The sequences that start in the last three bytes of those blocks
+    // are checked with the next block, the caller checks them again.
+    inline size_t validate_utf8_blocks(const unsigned char* bytes, size_t size, size_t& utf16Length, bool& asciiOnly) noexcept
+    {
+        size_t i = 0;
+#if defined(WIN32APP_UTF8_SSSE3)
+        const utf8_block_checker checker;
+        auto previous = _mm_setzero_si128();
+        auto previousIncomplete = _mm_setzero_si128();
+        // 64 bytes at a time, one branch for ASCII and one for errors.
+        for (; i + 64 <= size; i += 64)
+        {
+            const auto input0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+            const auto input1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i + 16));
+            const auto input2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i + 32));
+            const auto input3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i + 48));
+            if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(input0, input1), _mm_or_si128(input2, input3))) == 0)
+            {
+                if (!utf8_block_checker::is_zero(previousIncomplete)) // a sequence cut short by ASCII
+                {
+                    break;
+                }
+                utf16Length += 64;
+            }
+            else
+            {
+                const auto error = _mm_or_si128(_mm_or_si128(checker.error(input0, previous), checker.error(input1, input0)),
+                    _mm_or_si128(checker.error(input2, input1), checker.error(input3, input2)));
+                if (!utf8_block_checker::is_zero(error))
+                {
+                    break;
+                }
+                previousIncomplete = checker.incomplete(input3);
+                utf16Length += utf8_block_checker::sum(_mm_add_epi8(_mm_add_epi8(utf8_block_checker::utf16_units(input0), utf8_block_checker::utf16_units(input1)),
+                    _mm_add_epi8(utf8_block_checker::utf16_units(input2), utf8_block_checker::utf16_units(input3))));
+                asciiOnly = false;
+            }
+            previous = input3;
+        }
+        for (; i + 16 <= size; i += 16)
+        {
+            const auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+            if (_mm_movemask_epi8(input) == 0)
+            {
+                if (!utf8_block_checker::is_zero(previousIncomplete))
+                {
+                    break;
+                }
+                utf16Length += 16;
+            }
+            else
+            {
+                if (!utf8_block_checker::is_zero(checker.error(input, previous)))
+                {
+                    break;
+                }
+                previousIncomplete = checker.incomplete(input);
+                utf16Length += utf8_block_checker::sum(utf8_block_checker::utf16_units(input));
+                asciiOnly = false;
+            }
+            previous = input;
+        }
+#else
+        const auto byte1High = vld1q_u8(c_byte1High);
+        const auto byte1Low = vld1q_u8(c_byte1Low);
+        const auto byte2High = vld1q_u8(c_byte2High);
+        const auto incompleteMax = vld1q_u8(c_incompleteMax);
+        const auto nibble = vdupq_n_u8(0x0F);
+        const auto zero = vdupq_n_u8(0);
+        auto previous = zero;
+        auto previousIncomplete = zero;
+        for (; i + 16 <= size; i += 16)
+        {
+            const auto input = vld1q_u8(bytes + i);
+            uint8x16_t error;
+            size_t length = 16;
+            const bool ascii = vmaxvq_u8(input) < 0x80;
+            if (ascii)
+            {
+                error = previousIncomplete; // a sequence cut short by ASCII at the start of the block
+                previousIncomplete = zero;
+            }
+            else
+            {
+                const auto previous1 = vextq_u8(previous, input, 15);
+                const auto special = vandq_u8(vandq_u8(vqtbl1q_u8(byte1High, vshrq_n_u8(previous1, 4)), vqtbl1q_u8(byte1Low, vandq_u8(previous1, nibble))),
+                    vqtbl1q_u8(byte2High, vshrq_n_u8(input, 4)));
+                // 0x80 where the byte is the third or fourth of a sequence, see the SSSE3 version.
+                const auto must23 = vorrq_u8(vqsubq_u8(vextq_u8(previous, input, 14), vdupq_n_u8(0xE0 - 0x80)),
+                    vqsubq_u8(vextq_u8(previous, input, 13), vdupq_n_u8(0xF0 - 0x80)));
+                error = veorq_u8(vandq_u8(must23, vdupq_n_u8(0x80)), special);
+                previousIncomplete = vqsubq_u8(input, incompleteMax);
+
+                const auto leads = vcgtq_s8(vreinterpretq_s8_u8(input), vdupq_n_s8(static_cast<int8_t>(0xBF)));
+                const auto fourByteLeads = vcgeq_u8(input, vdupq_n_u8(0xF0));
+                length = vaddvq_u8(vshrq_n_u8(leads, 7)) + vaddvq_u8(vshrq_n_u8(fourByteLeads, 7));
+            }
+            if (vmaxvq_u8(error) != 0)
+            {
+                break;
+            }
+            asciiOnly = asciiOnly && ascii;
+            utf16Length += length;
+            previous = input;
+        }
+#endif
+        return i;
+    }
+#endif
+
+    // Converts text that validate_utf8() accepted, writing exactly utf16_length code units to output.
+    template <typename TChar>
+    void utf8_to_utf16_unchecked(std::string_view text, TChar* output) noexcept
+    {
+        const auto bytes = reinterpret_cast<const unsigned char*>(text.data());
+        const size_t size = text.size();
+        size_t i = 0;
+        while (i < size)
+        {
+            const auto asciiLength = ascii_prefix_length(bytes + i, size - i);
+            for (const auto end = i + asciiLength; i < end; i++)
+            {
+                *output++ = static_cast<TChar>(bytes[i]);
+            }
+            if (i == size)
+            {
+                break;
+            }
+
+            const unsigned char lead = bytes[i];
+            if (lead < 0xE0)
+            {
+                *output++ = static_cast<TChar>(((lead & 0x1F) << 6) | (bytes[i + 1] & 0x3F));
+                i += 2;
+            }
+            else if (lead < 0xF0)
+            {
+                *output++ = static_cast<TChar>(((lead & 0x0F) << 12) | ((bytes[i + 1] & 0x3F) << 6) | (bytes[i + 2] & 0x3F));
+                i += 3;
+            }
+            else
+            {
+                const uint32_t codePoint = (((lead & 0x07) << 18) | ((bytes[i + 1] & 0x3F) << 12) | ((bytes[i + 2] & 0x3F) << 6) | (bytes[i + 3] & 0x3F)) - 0x10000;
+                *output++ = static_cast<TChar>(0xD800 + (codePoint >> 10));
+                *output++ = static_cast<TChar>(0xDC00 + (codePoint & 0x3FF));
+                i += 4;
+            }
+        }
+    }
+} // namespace details
+
+inline utf8_validation_result validate_utf8(std::string_view text) noexcept
+{
+    const auto bytes = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t size = text.size();
+
+    utf8_validation_result result{true, true, size, 0};
+    size_t i = 0;
+#if defined(WIN32APP_UTF8_SSSE3) || defined(WIN32APP_UTF8_NEON)
+    if (const auto checked = details::validate_utf8_blocks(bytes, size, result.utf16_length, result.ascii_only); checked > 0)
+    {
+        // Continue from the start of the sequence that may be unfinished, it is at most 3 bytes before the end
+        // of the blocks that passed, and take back what those bytes added to the UTF-16 length.
+        i = checked - 3;
+        while ((bytes[i] & 0xC0) == 0x80)
+        {
+            i--;
+        }
+        for (auto j = i; j < checked; j++)
+        {
+            result.utf16_length -= ((bytes[j] & 0xC0) != 0x80) + (bytes[j] >= 0xF0);
+        }
+    }
+#endif
+    while (i < size)
+    {
+        const auto asciiLength = details::ascii_prefix_length(bytes + i, size - i);
+        i += asciiLength;
+        result.utf16_length += asciiLength;
+        if (i == size)
+        {
+            break;
+        }
+
+        result.ascii_only = false;
+        const auto length = details::utf8_sequence_length(bytes + i, size - i);
+        if (length == 0)
+        {
+            result.valid = false;
+            result.error_offset = i;
+            break;
+        }
+        i += length;
+        result.utf16_length += (length == 4) ? 2 : 1; // 4 byte sequences need a surrogate pair
+    }
+    return result;
+}
+} // namespace win32app
@@ -4,176 +4,52 @@
 
 #include <wil/win32_helpers.h>
 #include <wil/stl.h>
+#include <atomic>
+#include <chrono>
+#include <iterator>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <winrt/Windows.UI.Xaml.Hosting.h>
 
-#include "is_detected.h"
+#include "dpi_context.h"
+#include "message_dispatch.h"
+#include "message_trace.h"
+#include "rundown_loop.h"
 
 namespace win32app
 {
 namespace details
 {
-    // Window Message dispatch implementation
-    // These types map message values to a function prototype that can handle them.
-    // Clients implement the function of the given name and parameter list and
-    // messages will get dispatched to them.
-    //
-    // The 'wparam' and 'lparam' are converted into message specific values and
-    // passed to the function.
-    // Conversions are to the Win32 primitive representation to enable the most flexibility.
+    // Off unless start_message_recording() was called, the window procedure checks this for every message.
+    inline std::atomic<bool> g_recordMessages{false};
 
-    template <unsigned int value_, typename T>
-    struct msg
+    inline message_recorder& message_recording()
     {
-        static constexpr unsigned int value = value_;
-        static constexpr bool is_valid = false;
-    };
-
-    template <typename T>
-    struct msg<WM_SIZE, T>
-    {
-        template <typename T>
-        using resultT = decltype(std::declval<T>().Size(std::declval<unsigned short>(), std::declval<unsigned short>()));
-        static constexpr bool is_valid = is_detected<resultT, T>::value;
-    };
-
-    template <typename T>
-    struct msg<WM_MOVE, T>
-    {
-        template <typename T>
-        using resultT = decltype(std::declval<T>().Move(std::declval<unsigned short>(), std::declval<unsigned short>()));
-        static constexpr bool is_valid = is_detected<resultT, T>::value;
-    };
-
-    template <typename T>
-    struct msg<WM_CREATE, T>
-    {
-        template <typename T>
-        using resultT = decltype(std::declval<T>().Create());
-        static constexpr bool is_valid = is_detected<resultT, T>::value;
-    };
-
-    template <typename T>
-    struct msg<WM_DESTROY, T>
-    {
-        template <typename T>
-        using resultT = decltype(std::declval<T>().Destroy());
-        static constexpr bool is_valid = is_detected<resultT, T>::value;
-    };
-
-    template <typename T>
-    struct msg<WM_PAINT, T>
-    {
-        template <typename T>
-        using resultT = decltype(std::declval<T>().Paint(std::declval<HDC>(), std::declval<const PAINTSTRUCT&>()));
-        static constexpr bool is_valid = is_detected<resultT, T>::value;
-    };
-
-    template <typename T>
-    struct msg<WM_COMMAND, T>
-    {
-        template <typename T>
-        using resultT = decltype(std::declval<T>().Command(std::declval<unsigned short>()));
-        static constexpr bool is_valid = is_detected<resultT, T>::value;
-    };
-
-    template <typename T>
-    struct msg<WM_DEVICECHANGE, T>
-    {
-        template <typename T>
-        using resultT = decltype(std::declval<T>().DeviceChange(std::declval<unsigned int>(), std::declval<void*>()));
-        static constexpr bool is_valid = is_detected<resultT, T>::value;
-    };
-
-    template <typename T>
-    struct msg<-1, T>
-    {
-        // UINT32, WPARAM, LPARAM
-        template <typename T>
-        using resultT =
-            decltype(std::declval<T>().HandleMessage(std::declval<UINT32>(), std::declval<WPARAM>(), std::declval<LPARAM>()));
-        static constexpr bool is_valid = is_detected<resultT, T>::value;
-    };
+        static message_recorder s_recorder;
+        return s_recorder;
+    }
 
     template <typename T>
-    auto HandleMessage(T* that, UINT32 message, WPARAM wparam, LPARAM lparam)
+    ATOM register_window_class(PCWSTR className)
     {
-        switch (message)
-        {
-        case WM_MOVE:
-            if constexpr (msg<WM_MOVE, T>::is_valid)
-            {
-                const WORD dx = LOWORD(lparam), dy = HIWORD(lparam);
-                return that->Move(dx, dy);
-            }
-            break;
-
-        case WM_SIZE:
-            if constexpr (msg<WM_SIZE, T>::is_valid)
-            {
-                const WORD dx = LOWORD(lparam), dy = HIWORD(lparam);
-                return that->Size(dx, dy);
-            }
-            break;
-
-        case WM_CREATE:
-            if constexpr (msg<WM_CREATE, T>::is_valid)
-            {
-                return that->Create();
-            }
-            break;
-
-        case WM_DESTROY:
-            if constexpr (msg<WM_DESTROY, T>::is_valid)
-            {
-                return that->Destroy();
-            }
-            break;
-
-        case WM_PAINT:
-            if constexpr (msg<WM_PAINT, T>::is_valid)
-            {
-                PAINTSTRUCT ps{};
-                auto hdc{BeginPaint(that->m_window.get(), &ps)};
-                auto result = that->Paint(hdc, ps);
-                EndPaint(that->m_window.get(), &ps);
-                return result;
-            }
-            break;
-
-        case WM_COMMAND:
-            if constexpr (msg<WM_COMMAND, T>::is_valid)
-            {
-                return that->Command(LOWORD(wparam));
-            }
-            break;
-
-        case WM_DEVICECHANGE:
-            if constexpr (msg<WM_DEVICECHANGE, T>::is_valid)
-            {
-                return that->DeviceChange(static_cast<UINT>(wparam), reinterpret_cast<void*>(lparam));
-            }
-            break;
-
-        default:
+        const auto module = wil::GetModuleInstanceHandle();
+        WNDCLASSEXW existing{sizeof(existing)};
+        if (const auto atom = GetClassInfoExW(module, className, &existing))
         {
-            if constexpr (msg<-1, T>::is_valid)
-            {
-                return that->HandleMessage(message, wparam, lparam);
-            }
-        }
-        break;
+            return static_cast<ATOM>(atom); // already registered, for example by a call at start up
         }
-        return DefWindowProcW(that->m_window.get(), message, wparam, lparam);
-    }
 
-    template <typename T>
-    void create_top_level_window(T& instance, DWORD styles, DWORD exStyles, PCWSTR className, PCWSTR title = nullptr)
-    {
+        WIN32APP_TRACE_SCOPE("RegisterClassExW");
         WNDCLASSEXW wcex{sizeof(wcex)};
         wcex.style = CS_HREDRAW | CS_VREDRAW;
         wcex.lpfnWndProc = [](HWND window, UINT message, WPARAM wparam, LPARAM lparam) noexcept -> LRESULT {
+            if (g_recordMessages.load(std::memory_order_relaxed))
+            {
+                message_recording().record(reinterpret_cast<uint64_t>(window), message, static_cast<uint64_t>(wparam), static_cast<int64_t>(lparam));
+            }
+
             if (message == WM_NCCREATE)
             {
                 auto cs = reinterpret_cast<CREATESTRUCT*>(lparam);
@@ -192,20 +68,66 @@ namespace details
 
             return DefWindowProcW(window, message, wparam, lparam);
         };
-        wcex.hInstance = wil::GetModuleInstanceHandle();
+        wcex.hInstance = module;
         auto imageResMod = LoadLibraryExW(L"imageres.dll", nullptr, LOAD_LIBRARY_SEARCH_SYSTEM32 | LOAD_LIBRARY_AS_DATAFILE);
         wcex.hIcon = LoadIconW(imageResMod, reinterpret_cast<const wchar_t*>(5206)); // App Icon
         wcex.hbrBackground = reinterpret_cast<HBRUSH>(COLOR_WINDOW + 1);
         wcex.hCursor = LoadCursorW(nullptr, IDC_ARROW);
         wcex.lpszClassName = className;
 
-        RegisterClassExW(&wcex);
+        return RegisterClassExW(&wcex);
+    }
+
+    template <typename T>
+    void create_top_level_window(T& instance, DWORD styles, DWORD exStyles, PCWSTR className, PCWSTR title = nullptr)
+    {
+        register_window_class<T>(className);
 
+        WIN32APP_TRACE_SCOPE("CreateWindowExW"); // includes WM_CREATE
         THROW_LAST_ERROR_IF(!CreateWindowExW(
             exStyles, className, L"Win32 App", styles, CW_USEDEFAULT, 0, CW_USEDEFAULT, 0, nullptr, nullptr, wil::GetModuleInstanceHandle(), &instance));
     }
 } // namespace details
 
+// Registers the window class create_top_level_window uses for T, if it is not registered yet.
+// create_top_level_window does this, calling it earlier (from any thread) takes the cost off the path
+// to the first window.
+template <typename T>
+ATOM register_window_class(PCWSTR className)
+{
+    return details::register_window_class<T>(className);
+}
+
+// Records the messages received by the windows created by create_top_level_window, on all threads, until
+// stop_message_recording() returns them. See message_trace.h for saving and replaying them.
+inline void start_message_recording()
+{
+    details::message_recording().restart();
+    details::g_recordMessages.store(true);
+}
+
+inline std::vector<message_record> stop_message_recording()
+{
+    details::g_recordMessages.store(false);
+    return details::message_recording().take();
+}
+
+// Feeds recorded messages through the handlers of instance, which must have a window, timing each one.
+// Only the messages recorded for window are replayed, all of them if it is 0, and of those only the ones
+// whose parameters are values, see is_replayable_message() in message_trace.h.
+template <typename T>
+replay_report replay_message_trace(T& instance, std::span<const message_record> records, replay_speed speed = replay_speed::full_speed, uint64_t window = 0)
+{
+    std::vector<message_record> replayable;
+    replayable.reserve(records.size());
+    std::copy_if(records.begin(), records.end(), std::back_inserter(replayable), [window](const message_record& record) {
+        return ((window == 0) || (record.window == window)) && is_replayable_message(record.message);
+    });
+    return replay_messages(replayable, [&](const message_record& record) {
+        details::HandleMessage(&instance, record.message, static_cast<WPARAM>(record.wparam), static_cast<LPARAM>(record.lparam));
+    }, speed);
+}
+
 // The created window is stored in T.m_window (must be wil::unique_hwnd).
 template <typename T>
 void create_top_level_window(T& instance, PCWSTR className, PCWSTR title = nullptr)
@@ -237,21 +159,32 @@ void enter_simple_message_loop(T& instance, UINT nCmdShow)
     }
 }
 
+namespace details
+{
+    // Returns the WindowsXamlManager that keeps Xaml alive on this thread until the rundown is done.
+    template <typename T>
+    [[nodiscard]] auto wait_for_com_shutdown_signal(T& instance, UINT nCmdShow, wil::unique_event& shutdownSignal)
+    {
+        auto w = instance.m_window.get();
+        ShowWindow(w, nCmdShow);
+        UpdateWindow(w);
+
+        // Ensure a continuous Xaml lifetime on this thread.
+        auto xamlManager = winrt::Windows::UI::Xaml::Hosting::WindowsXamlManager::InitializeForCurrentThread();
+
+        DWORD index{};
+        HANDLE waitArray[]{shutdownSignal.get()};
+        FAIL_FAST_IF_FAILED(CoWaitForMultipleHandles(
+            COWAIT_DISPATCH_CALLS | COWAIT_DISPATCH_WINDOW_MESSAGES, INFINITE, ARRAYSIZE(waitArray), waitArray, &index));
+        return xamlManager;
+    }
+} // namespace details
+
 // T must have wil::unique_hwnd m_window.
 template <typename T>
 void enter_com_message_loop(T& instance, UINT nCmdShow, wil::unique_event& shutdownSignal)
 {
-    auto w = instance.m_window.get();
-    ShowWindow(w, nCmdShow);
-    UpdateWindow(w);
-
-    // Ensure a continuous Xaml lifetime on this thread.
-    auto xamlManager = winrt::Windows::UI::Xaml::Hosting::WindowsXamlManager::InitializeForCurrentThread();
-
-    DWORD index{};
-    HANDLE waitArray[]{shutdownSignal.get()};
-    FAIL_FAST_IF_FAILED(CoWaitForMultipleHandles(
-        COWAIT_DISPATCH_CALLS | COWAIT_DISPATCH_WINDOW_MESSAGES, INFINITE, ARRAYSIZE(waitArray), waitArray, &index));
+    auto xamlManager = details::wait_for_com_shutdown_signal(instance, nCmdShow, shutdownSignal);
 
     // Need an extra message loop to enable Xaml to finish its rundown.
     PostQuitMessage(0); // ensures we terminate the loop when Xaml is done.
@@ -262,6 +195,37 @@ void enter_com_message_loop(T& instance, UINT nCmdShow, wil::unique_event& shutd
     }
 }
 
+// Like enter_com_message_loop but the rundown after the shutdown signal is bounded by rundownTimeout.
+// Returns false if the rundown did not finish in time, the caller can report what is outstanding
+// (see shutdown_tracker.h) and exit anyway.
+// T must have wil::unique_hwnd m_window.
+template <typename T, typename Rep, typename Period>
+bool enter_com_message_loop(T& instance, UINT nCmdShow, wil::unique_event& shutdownSignal, std::chrono::duration<Rep, Period> rundownTimeout)
+{
+    auto xamlManager = details::wait_for_com_shutdown_signal(instance, nCmdShow, shutdownSignal);
+
+    WIN32APP_TRACE_SCOPE("Xaml rundown");
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(rundownTimeout);
+    PostQuitMessage(0); // WM_QUIT is retrieved once the messages Xaml posts during rundown are done
+    return run_until_quit(
+        deadline,
+        []() {
+            MSG msg{};
+            while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE))
+            {
+                if (msg.message == WM_QUIT)
+                {
+                    return true;
+                }
+                DispatchMessageW(&msg);
+            }
+            return false;
+        },
+        [](std::chrono::milliseconds remaining) {
+            MsgWaitForMultipleObjectsEx(0, nullptr, static_cast<DWORD>(remaining.count()), QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+        });
+}
+
 // Includes the trailing slash to make it easy to combine with a file name.
 inline std::wstring GetModuleFolder(HINSTANCE module = wil::GetModuleInstanceHandle())
 {
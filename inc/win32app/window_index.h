@@ -0,0 +1,278 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "window_snapshot.h"
+
+// window_index
+//
+// A live index of windows keyed by handle, kept current from window events (created, destroyed,
+// shown, hidden, name and location changes) instead of polling every window on a timer.
+//
+// Events arrive faster than they are worth handling, a window being dragged reports a location
+// change per mouse move. window_event_queue coalesces them per window, any thread can post, and
+// the owner of the index takes the pending events as a batch and applies them. Applying re-reads only
+// the attributes the events say changed, through a query function, and reports the windows that
+// were added, removed and changed to the subscribers.
+//
+//    win32app::window_event_queue queue;
+//    win32app::window_index index;
+//    auto id = index.subscribe([](const win32app::window_index_changes& changes) { ... });
+//
+//    if (queue.post(handle, win32app::window_location_changed)) { schedule a flush; }
+//
+//    index.apply(queue.take(), [](uint64_t handle, uint8_t events, win32app::window_attributes& attributes) {
+//        // read the attributes selected by events, return false if the window should not be indexed
+//    });
+//
+// LiveWindowIndex in Win32UI.h feeds this from SetWinEventHook. The index is not thread safe, it is
+// used by the thread that applies the batches.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+// Flags, a pending entry combines the events posted for a window since the last batch.
+enum window_event : uint8_t
+{
+    window_created = 0x01,
+    window_destroyed = 0x02,
+    window_shown = 0x04,
+    window_hidden = 0x08,
+    window_name_changed = 0x10,
+    window_location_changed = 0x20,
+    window_style_changed = 0x40, // minimized, restored and other changes that only affect the styles
+};
+
+// The events that require each attribute to be re-read, a created window requires all of them.
+namespace window_event_reads
+{
+    constexpr uint8_t styles = window_created | window_shown | window_hidden | window_style_changed;
+    constexpr uint8_t rect = window_created | window_shown | window_location_changed | window_style_changed;
+    constexpr uint8_t owner = window_created;
+    constexpr uint8_t title = window_created | window_name_changed;
+} // namespace window_event_reads
+
+struct window_attributes
+{
+    uint32_t style{};
+    uint32_t exStyle{};
+    layout_rect rect{};
+    uint64_t owner{};
+    std::wstring title;
+
+    bool is_app_like() const
+    {
+        return is_app_like_window(style, exStyle, rect, owner);
+    }
+};
+
+struct pending_window_events
+{
+    uint64_t handle;
+    uint8_t events; // window_event flags
+};
+
+// Coalesces events per window until they are taken as a batch. Thread safe.
+struct window_event_queue
+{
+    // Returns true if this is the first event of a new batch, the caller should arrange for take() to be
+    // called, other events will be coalesced into that batch.
+    bool post(uint64_t handle, uint8_t events)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_posted++;
+        const auto [entry, inserted] = m_positions.try_emplace(handle, m_pending.size());
+        if (inserted)
+        {
+            m_pending.push_back({handle, events});
+            return m_pending.size() == 1;
+        }
+
+        auto& pending = m_pending[entry->second].events;
+        if (events & window_destroyed)
+        {
+            pending = window_destroyed; // nothing else matters
+        }
+        else if (pending & window_destroyed)
+        {
+            pending = events | window_created; // the handle was reused, read the new window
+        }
+        else
+        {
+            pending |= events;
+        }
+        return false;
+    }
+
+    // The coalesced events in the order their windows first appeared in the batch.
+    std::vector<pending_window_events> take()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_positions.clear();
+        return std::exchange(m_pending, {});
+    }
+
+    size_t pending() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_pending.size();
+    }
+
+    // The number of events posted, compare with the number of windows applied to see the coalescing.
+    size_t posted() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_posted;
+    }
+
+private:
+    mutable std::mutex m_lock;
+    std::vector<pending_window_events> m_pending;
+    std::unordered_map<uint64_t, size_t> m_positions; // handle to index in m_pending
+    size_t m_posted{};
+};
+
+struct window_index_changes
+{
+    std::vector<uint64_t> added;
+    std::vector<uint64_t> removed;
+    std::vector<uint64_t> changed;
+
+    bool empty() const
+    {
+        return added.empty() && removed.empty() && changed.empty();
+    }
+};
+
+struct window_index
+{
+    using subscriber = std::function<void(const window_index_changes&)>;
+
+    // Applies a batch. For each window that was not destroyed query(handle, events, attributes) re-reads the
+    // attributes events selects (see window_event_reads) into attributes, which holds the indexed values or default
+    // values for a window that is not indexed yet, and returns false if the window should not be indexed.
+    // The subscribers are called with the changes if there are any.
+    template <typename TQuery>
+    window_index_changes apply(std::span<const pending_window_events> batch, TQuery&& query)
+    {
+        window_index_changes changes;
+        for (const auto& pending : batch)
+        {
+            auto existing = m_windows.find(pending.handle);
+            if (pending.events & window_destroyed)
+            {
+                if (existing != m_windows.end())
+                {
+                    m_windows.erase(existing);
+                    changes.removed.push_back(pending.handle);
+                }
+                continue;
+            }
+
+            const bool isNew = (existing == m_windows.end());
+            window_attributes attributes = isNew ? window_attributes{} : existing->second;
+            const auto events = static_cast<uint8_t>(isNew ? (pending.events | window_created) : pending.events);
+            if (!query(pending.handle, events, attributes))
+            {
+                if (!isNew)
+                {
+                    m_windows.erase(existing);
+                    changes.removed.push_back(pending.handle);
+                }
+            }
+            else if (isNew)
+            {
+                m_windows.emplace(pending.handle, std::move(attributes));
+                changes.added.push_back(pending.handle);
+            }
+            else if (differ(existing->second, attributes))
+            {
+                existing->second = std::move(attributes);
+                changes.changed.push_back(pending.handle);
+            }
+        }
+
+        m_batches++;
+        if (!changes.empty())
+        {
+            for (const auto& [id, callback] : m_subscribers)
+            {
+                callback(changes);
+            }
+        }
+        return changes;
+    }
+
+    // Returns an id for unsubscribe().
+    size_t subscribe(subscriber callback)
+    {
+        m_subscribers.emplace_back(++m_lastSubscriberId, std::move(callback));
+        return m_lastSubscriberId;
+    }
+
+    void unsubscribe(size_t id)
+    {
+        std::erase_if(m_subscribers, [id](const auto& entry) { return entry.first == id; });
+    }
+
+    // nullptr if the window is not indexed.
+    const window_attributes* find(uint64_t handle) const
+    {
+        const auto found = m_windows.find(handle);
+        return (found != m_windows.end()) ? &found->second : nullptr;
+    }
+
+    size_t size() const
+    {
+        return m_windows.size();
+    }
+
+    // The number of batches applied.
+    size_t batches() const
+    {
+        return m_batches;
+    }
+
+    // fn(handle, attributes) for each indexed window, in no particular order.
+    template <typename TFn>
+    void for_each(TFn&& fn) const
+    {
+        for (const auto& [handle, attributes] : m_windows)
+        {
+            fn(handle, attributes);
+        }
+    }
+
+    // The windows IsAppLikeWindow accepts, excluding filterWindow.
+    std::vector<uint64_t> app_like_windows(uint64_t filterWindow = 0) const
+    {
+        std::vector<uint64_t> result;
+        for (const auto& [handle, attributes] : m_windows)
+        {
+            if ((handle != filterWindow) && attributes.is_app_like())
+            {
+                result.push_back(handle);
+            }
+        }
+        return result;
+    }
+
+private:
+    static bool differ(const window_attributes& left, const window_attributes& right)
+    {
+        return (left.style != right.style) || (left.exStyle != right.exStyle) || (left.rect != right.rect) || (left.owner != right.owner) ||
+               (left.title != right.title);
+    }
+
+    std::unordered_map<uint64_t, window_attributes> m_windows;
+    std::vector<std::pair<size_t, subscriber>> m_subscribers;
+    size_t m_lastSubscriberId{};
+    size_t m_batches{};
+};
+} // namespace win32app
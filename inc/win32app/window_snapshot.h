@@ -0,0 +1,213 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "layout_rect.h"
+#include "utf16_string_table.h"
+
+// window_snapshot
+//
+// The attributes of a set of windows (normally every top level window) captured in one pass, stored
+// as a structure of arrays so filtering and comparing them is a scan over compact arrays rather than
+// a set of system calls per window. Titles are kept in one text arena, see utf16_string_table.h.
+//
+//    auto snapshot = CaptureTopLevelWindows(true);                // Win32UI.h
+//    for (auto index : win32app::app_like_windows(snapshot)) { ... }
+//
+//    auto changes = win32app::diff(previous, snapshot);           // added, removed and changed windows
+//
+// Handles are stored as integers. Styles use the values of the Win32 WS_ and WS_EX_ flags.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+namespace window_style
+{
+    constexpr uint32_t visible = 0x10000000;     // WS_VISIBLE
+    constexpr uint32_t minimized = 0x20000000;   // WS_MINIMIZE
+    constexpr uint32_t ex_tool_window = 0x00000080; // WS_EX_TOOLWINDOW
+    constexpr uint32_t ex_no_activate = 0x08000000; // WS_EX_NOACTIVATE
+} // namespace window_style
+
+// The part of the IsAppLikeWindow policy decided by the styles: visible, not minimized, not a tool
+// window and can take activation.
+constexpr bool is_app_like_style(uint32_t style, uint32_t exStyle)
+{
+    return ((style & window_style::visible) != 0) && ((style & window_style::minimized) == 0) &&
+           ((exStyle & (window_style::ex_tool_window | window_style::ex_no_activate)) == 0);
+}
+
+// The IsAppLikeWindow policy, the styles and a non-empty rect and no owner.
+constexpr bool is_app_like_window(uint32_t style, uint32_t exStyle, const layout_rect& rect, uint64_t owner)
+{
+    return is_app_like_style(style, exStyle) && (rect.left != rect.right) && (rect.top != rect.bottom) && (owner == 0);
+}
+
+struct window_snapshot
+{
+    void reserve(size_t count)
+    {
+        m_handles.reserve(count);
+        m_styles.reserve(count);
+        m_exStyles.reserve(count);
+        m_rects.reserve(count);
+        m_owners.reserve(count);
+        m_titles.m_offsets.reserve(count + 1);
+    }
+
+    void add(uint64_t handle, uint32_t style, uint32_t exStyle, const layout_rect& rect, uint64_t owner, std::wstring_view title = {})
+    {
+        if (m_titles.m_offsets.empty())
+        {
+            m_titles.m_offsets.push_back(0);
+        }
+        m_handles.push_back(handle);
+        m_styles.push_back(style);
+        m_exStyles.push_back(exStyle);
+        m_rects.push_back(rect);
+        m_owners.push_back(owner);
+        m_titles.m_text.insert(m_titles.m_text.end(), title.begin(), title.end());
+        m_titles.m_text.push_back(L'\0');
+        m_titles.m_offsets.push_back(static_cast<uint32_t>(m_titles.m_text.size()));
+    }
+
+    size_t size() const
+    {
+        return m_handles.size();
+    }
+
+    uint64_t handle(size_t index) const
+    {
+        return m_handles[index];
+    }
+
+    uint32_t style(size_t index) const
+    {
+        return m_styles[index];
+    }
+
+    uint32_t ex_style(size_t index) const
+    {
+        return m_exStyles[index];
+    }
+
+    const layout_rect& rect(size_t index) const
+    {
+        return m_rects[index];
+    }
+
+    uint64_t owner(size_t index) const
+    {
+        return m_owners[index];
+    }
+
+    // Empty if titles were not captured.
+    std::wstring_view title(size_t index) const
+    {
+        return m_titles[index];
+    }
+
+    std::span<const uint64_t> handles() const
+    {
+        return m_handles;
+    }
+
+    bool is_app_like(size_t index) const
+    {
+        return is_app_like_window(m_styles[index], m_exStyles[index], m_rects[index], m_owners[index]);
+    }
+
+    // Same handle, different attributes.
+    bool attributes_differ(size_t index, const window_snapshot& other, size_t otherIndex) const
+    {
+        return (m_styles[index] != other.m_styles[otherIndex]) || (m_exStyles[index] != other.m_exStyles[otherIndex]) ||
+               (m_rects[index] != other.m_rects[otherIndex]) || (m_owners[index] != other.m_owners[otherIndex]) ||
+               (title(index) != other.title(otherIndex));
+    }
+
+private:
+    std::vector<uint64_t> m_handles;
+    std::vector<uint32_t> m_styles;
+    std::vector<uint32_t> m_exStyles;
+    std::vector<layout_rect> m_rects;
+    std::vector<uint64_t> m_owners;
+    basic_utf16_string_table<wchar_t> m_titles;
+};
+
+// The indexes of the windows that satisfy predicate(snapshot, index), in snapshot order. This is one pass
+// on the calling thread, a desktop has hundreds of top level windows and filtering them takes a few
+// microseconds, less than starting a thread to share the work with.
+template <typename TPredicate>
+std::vector<uint32_t> filter(const window_snapshot& snapshot, TPredicate&& predicate)
+{
+    std::vector<uint32_t> result;
+    for (size_t i = 0; i < snapshot.size(); i++)
+    {
+        if (predicate(snapshot, i))
+        {
+            result.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    return result;
+}
+
+// The windows IsAppLikeWindow accepts, excluding filterWindow.
+inline std::vector<uint32_t> app_like_windows(const window_snapshot& snapshot, uint64_t filterWindow = 0)
+{
+    return filter(snapshot, [filterWindow](const window_snapshot& s, size_t index) { return (s.handle(index) != filterWindow) && s.is_app_like(index); });
+}
+
+struct window_snapshot_diff
+{
+    std::vector<uint32_t> added;   // indexes in the later snapshot
+    std::vector<uint32_t> removed; // indexes in the earlier snapshot
+    std::vector<uint32_t> changed; // indexes in the later snapshot of windows whose attributes changed
+};
+
+inline window_snapshot_diff diff(const window_snapshot& before, const window_snapshot& after)
+{
+    const auto sortedByHandle = [](const window_snapshot& snapshot) {
+        std::vector<uint32_t> order(snapshot.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t left, uint32_t right) { return snapshot.handle(left) < snapshot.handle(right); });
+        return order;
+    };
+    const auto beforeOrder = sortedByHandle(before);
+    const auto afterOrder = sortedByHandle(after);
+
+    window_snapshot_diff result;
+    size_t b = 0, a = 0;
+    while ((b < beforeOrder.size()) || (a < afterOrder.size()))
+    {
+        if ((a == afterOrder.size()) || ((b < beforeOrder.size()) && (before.handle(beforeOrder[b]) < after.handle(afterOrder[a]))))
+        {
+            result.removed.push_back(beforeOrder[b++]);
+        }
+        else if ((b == beforeOrder.size()) || (after.handle(afterOrder[a]) < before.handle(beforeOrder[b])))
+        {
+            result.added.push_back(afterOrder[a++]);
+        }
+        else
+        {
+            if (after.attributes_differ(afterOrder[a], before, beforeOrder[b]))
+            {
+                result.changed.push_back(afterOrder[a]);
+            }
+            a++;
+            b++;
+        }
+    }
+
+    std::sort(result.added.begin(), result.added.end());
+    std::sort(result.removed.begin(), result.removed.end());
+    std::sort(result.changed.begin(), result.changed.end());
+    return result;
+}
+} // namespace win32app
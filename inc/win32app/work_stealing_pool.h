@@ -0,0 +1,251 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// work_stealing_pool
+//
+// Background threads for CPU heavy work started by window handlers, so it does not run on the UI
+// thread or on threads created for each piece of work. Each worker has its own queue, work submitted
+// from a worker goes to its own queue and is run newest first, idle workers steal the oldest work
+// from the other queues. Idle workers sleep until work is submitted.
+//
+// Work can be tied to a cancellation_source, for example one owned by a window that is cancelled when
+// the window is destroyed. Cancelled work is not run, a coroutine scheduled with a cancelled token is
+// resumed with false so it can return.
+//
+//    win32app::work_stealing_pool pool; // one worker per core
+//
+//    pool.submit([] { work(); });
+//
+//    if (co_await pool.schedule(m_cancellation.token()))
+//    {
+//        // now on a worker thread
+//    }
+//
+// The destructor runs the remaining work and joins the workers.
+// This has no dependency on the Windows headers.
+
+namespace win32app
+{
+struct cancellation_token
+{
+    cancellation_token() = default;
+
+    bool is_cancelled() const
+    {
+        return m_state && m_state->load(std::memory_order_acquire);
+    }
+
+private:
+    friend struct cancellation_source;
+
+    explicit cancellation_token(std::shared_ptr<const std::atomic<bool>> state) : m_state(std::move(state))
+    {
+    }
+
+    std::shared_ptr<const std::atomic<bool>> m_state; // null for tokens that are never cancelled
+};
+
+struct cancellation_source
+{
+    cancellation_token token() const
+    {
+        return cancellation_token(m_state);
+    }
+
+    void cancel()
+    {
+        m_state->store(true, std::memory_order_release);
+    }
+
+    bool is_cancelled() const
+    {
+        return m_state->load(std::memory_order_acquire);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_state{std::make_shared<std::atomic<bool>>(false)};
+};
+
+struct work_stealing_pool
+{
+    // threadCount 0 uses one worker per core.
+    explicit work_stealing_pool(size_t threadCount = 0) :
+        m_workers(threadCount ? threadCount : std::max<size_t>(std::thread::hardware_concurrency(), 1))
+    {
+        m_threads.reserve(m_workers.size());
+        for (size_t i = 0; i < m_workers.size(); i++)
+        {
+            m_threads.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ~work_stealing_pool()
+    {
+        m_stopping.store(true);
+        wake(true);
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    // fn is not run if token is cancelled before it starts.
+    void submit(std::function<void()> fn, cancellation_token token = {})
+    {
+        // Workers submit to their own queue, other threads spread their work over the queues.
+        const auto worker = (t_currentPool == this) ? t_currentWorker : (m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size());
+        {
+            auto& queue = m_workers[worker];
+            std::lock_guard<std::mutex> lock(queue.lock);
+            queue.tasks.push_back({std::move(fn), std::move(token)});
+        }
+        wake(false);
+    }
+
+    struct schedule_awaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            // Not submitted with the token, the coroutine must always be resumed to run its destructors.
+            m_pool.submit([handle] { handle.resume(); });
+        }
+
+        // false if the token was cancelled, the coroutine should return without doing its work.
+        bool await_resume() const noexcept
+        {
+            return !m_token.is_cancelled();
+        }
+
+        work_stealing_pool& m_pool;
+        cancellation_token m_token;
+    };
+
+    // co_await pool.schedule(token) continues the coroutine on a worker thread.
+    [[nodiscard]] schedule_awaiter schedule(cancellation_token token = {})
+    {
+        return {*this, std::move(token)};
+    }
+
+    size_t thread_count() const
+    {
+        return m_workers.size();
+    }
+
+private:
+    struct task
+    {
+        std::function<void()> fn;
+        cancellation_token token;
+    };
+
+    struct alignas(64) worker_queue
+    {
+        std::mutex lock;
+        std::deque<task> tasks;
+    };
+
+    std::optional<task> find_task(size_t worker)
+    {
+        {
+            auto& own = m_workers[worker];
+            std::lock_guard<std::mutex> lock(own.lock);
+            if (!own.tasks.empty())
+            {
+                auto result = std::move(own.tasks.back()); // newest first, its data is likely in the cache
+                own.tasks.pop_back();
+                return result;
+            }
+        }
+
+        for (size_t i = 1; i < m_workers.size(); i++)
+        {
+            auto& victim = m_workers[(worker + i) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(victim.lock);
+            if (!victim.tasks.empty())
+            {
+                auto result = std::move(victim.tasks.front()); // steal the oldest
+                victim.tasks.pop_front();
+                return result;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void worker_loop(size_t worker)
+    {
+        t_currentPool = this;
+        t_currentWorker = worker;
+
+        for (;;)
+        {
+            if (auto work = find_task(worker))
+            {
+                if (!work->token.is_cancelled())
+                {
+                    work->fn();
+                }
+                continue;
+            }
+
+            // Read the epoch before checking again, work submitted after the check changes it so the wait returns.
+            const auto epoch = m_epoch.load();
+            if (auto work = find_task(worker))
+            {
+                if (!work->token.is_cancelled())
+                {
+                    work->fn();
+                }
+                continue;
+            }
+            if (m_stopping.load())
+            {
+                break; // the queues are empty
+            }
+
+            m_sleeping.fetch_add(1);
+            m_epoch.wait(epoch);
+            m_sleeping.fetch_sub(1);
+        }
+
+        t_currentPool = nullptr;
+    }
+
+    void wake(bool all)
+    {
+        m_epoch.fetch_add(1);
+        if (m_sleeping.load() != 0)
+        {
+            all ? m_epoch.notify_all() : m_epoch.notify_one();
+        }
+    }
+
+    std::vector<worker_queue> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_nextWorker{0};
+    std::atomic<uint32_t> m_epoch{0};
+    std::atomic<int> m_sleeping{0};
+    std::atomic<bool> m_stopping{false};
+
+    inline static thread_local work_stealing_pool* t_currentPool{};
+    inline static thread_local size_t t_currentWorker{};
+};
+} // namespace win32app